@@ -0,0 +1,23 @@
+#!/usr/bin/env bash
+
+# Benchmark of the program on synthetic workloads of 10^3 events up to
+# 10^MAX_EXP events (6 by default, i.e. a million), see "Benchmark" in the
+# readme. Any further inputs are options for venBench, e.g. the workload
+# options of bench/workload.h, or -m file to skip the streams:
+#   bench/bench.sh 8 -u 1000000 -s 1.2
+
+MAX_EXP=${1:-6}
+shift
+
+cd "$(dirname "$0")/.."
+
+# the program is compiled just as in run.sh, so the numbers are those of
+# the program as it is run
+eval "$(grep '^gcc' run.sh)" || exit 1
+gcc -O2 -std=c99 -pthread -Wall bench/workload.h bench/workload.c bench/venGen.c -lm -o bench/venGen || exit 1
+gcc -O2 -std=c99 -pthread -Wall bench/workload.h bench/workload.c bench/venBench.c -lm -o bench/venBench || exit 1
+
+bench/venBench -H
+for ((e=3; e<=MAX_EXP; e++)); do
+	bench/venBench -n 1e$e "$@" ./venGraph || exit 1
+done
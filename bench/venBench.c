@@ -0,0 +1,397 @@
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <assert.h>
+#include <signal.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include "workload.h"
+
+// venBench runs the compiled program on a synthetic workload (see
+// "workload.h") and reports how fast it goes, in one line per mode:
+//
+//   file    the workload is written to a temporary file first, and the
+//           program replays it, as in run.sh. The events per second are
+//           taken over the whole run, start-up included.
+//   stream  the workload is fed to the program through a pipe as it is
+//           generated, and the median of every valid line is read back
+//           from another pipe. The latency of an event is the time from
+//           the moment its line is written until its median comes back.
+//
+// Both report the peak resident memory of the program. Usage:
+//   ./venBench [workload options] [-m file|stream|both] [-p rate] [-w windows] venGraph
+// -p paces the stream at the given number of lines per second of the wall
+// clock; by default the lines are written as fast as the program takes them.
+// Then the latency of a line is counted from when it was due, not from
+// when it was finally written, so a stall shows up in every line it holds
+// up. -w is passed on as the windows input of the program, and -H prints
+// the header of the columns.
+
+// The latencies go into a histogram of log-linear buckets: exact below
+// 2^SUB_BITS nanoseconds, and in steps of 1/2^(SUB_BITS-1) of a power of
+// two above, so every value is within about 3% of its bucket.
+#define SUB_BITS 6
+#define SUB_COUNT (1 << SUB_BITS)
+#define HALF_COUNT (SUB_COUNT / 2)
+#define NUM_BUCKETS (SUB_COUNT + 58*HALF_COUNT)
+
+// The send times of the lines still waiting for their medians. The sender
+// never gets more than PENDING_SIZE valid lines ahead of the reader.
+#define PENDING_SIZE (1 << 20)
+
+// the size of the pieces the lines are written in, if not paced
+#define SEND_CHUNK 4096
+
+typedef struct {
+	workloadParams params;
+	double pace;				// lines per second, or 0
+	int fd;						// the input of the program
+	uint64_t* sent;				// send times, indexed by valid line
+	unsigned long int received;	// the number of medians read back so far
+	unsigned long int valid;	// the number of valid lines sent
+} sender;
+
+typedef struct {
+	uint64_t counts[NUM_BUCKETS];
+	uint64_t total;
+	uint64_t max;
+} histogram;
+
+static uint64_t nowNanos() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec*1000000000 + ts.tv_nsec;
+}
+
+static int bucketOf(uint64_t v) {
+
+	int shift;
+
+	if (v < SUB_COUNT)
+		return (int)v;
+	shift = 63 - __builtin_clzll(v) - (SUB_BITS - 1);
+	return SUB_COUNT + (shift - 1)*HALF_COUNT + (int)((v >> shift) - HALF_COUNT);
+}
+
+// the smallest value that falls into bucket b
+static uint64_t bucketValue(int b) {
+
+	int shift;
+
+	if (b < SUB_COUNT)
+		return b;
+	shift = (b - SUB_COUNT)/HALF_COUNT + 1;
+	return (uint64_t)(HALF_COUNT + (b - SUB_COUNT) % HALF_COUNT) << shift;
+}
+
+static void record(histogram* H, uint64_t v) {
+	H->counts[bucketOf(v)]++;
+	H->total++;
+	if (v > H->max)
+		H->max = v;
+}
+
+// the latency that a fraction p of the events do not exceed
+static uint64_t percentile(histogram* H, double p) {
+
+	uint64_t rank = (uint64_t)(p * H->total);
+	uint64_t seen = 0;
+	int b;
+
+	for (b=0; b<NUM_BUCKETS; b++) {
+		seen = seen + H->counts[b];
+		if (seen > rank)
+			return bucketValue(b);
+	}
+	return H->max;
+}
+
+// start the program with its standard input and output on the given
+// descriptors (or left alone, if -1). Whatever the program reports besides
+// the medians goes to /dev/null.
+static pid_t launch(char** args, int in, int out) {
+
+	pid_t pid = fork();
+	int null;
+
+	if (pid < 0) {
+		printf("\n\nFATAL ERROR: cannot fork\n\n");
+		abort();
+	}
+	if (pid == 0) {
+		null = open("/dev/null", O_WRONLY);
+		if (in >= 0)
+			dup2(in, 0);
+		dup2(out >= 0 ? out : null, 1);
+		dup2(null, 2);
+		execv(args[0], args);
+		_exit(127);
+	}
+	return pid;
+}
+
+// wait for the program, and return its peak resident memory in kilobytes
+static long int finish(pid_t pid) {
+
+	struct rusage usage;
+	int status;
+
+	if (wait4(pid, &status, 0, &usage) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+		printf("\n\nERROR: the program did not run to the end\n\n");
+		exit(1);
+	}
+	return usage.ru_maxrss;
+}
+
+static void report(char* mode, workloadParams* P, double seconds, histogram* H, long int rss) {
+
+	printf("%-8s %12lu %12.0f", mode, P->events, P->events / seconds);
+	if (H != NULL)
+		printf(" %10.1f %10.1f %10.1f %10.1f %10.1f", percentile(H, 0.50)/1e3, percentile(H, 0.90)/1e3,
+			percentile(H, 0.99)/1e3, percentile(H, 0.999)/1e3, H->max/1e3);
+	else
+		printf(" %10s %10s %10s %10s %10s", "-", "-", "-", "-", "-");
+	printf(" %12ld\n", rss);
+	fflush(stdout);
+}
+
+static void runFile(workloadParams* P, char** args) {
+
+	char path[] = "/tmp/venBench.XXXXXX";
+	char line[WORKLOAD_MAX_LINE];
+	int fd = mkstemp(path);
+	int len, valid;
+	FILE* fp;
+	workload* W;
+	uint64_t start;
+	long int rss;
+
+	if (fd < 0 || (fp = fdopen(fd, "w")) == NULL) {
+		printf("\n\nERROR: temporary file could not be created\n\n");
+		exit(1);
+	}
+	setvbuf(fp, NULL, _IOFBF, 1 << 20);
+	W = workload_create(P);
+	while ((len = workload_next(W, line, &valid)) > 0)
+		fwrite(line, 1, len, fp);
+	workload_destroy(W);
+	fclose(fp);
+
+	args[1] = path;
+	args[2] = "/dev/null";
+	start = nowNanos();
+	rss = finish(launch(args, -1, -1));
+	report("file", P, (nowNanos() - start)*1e-9, NULL, rss);
+
+	unlink(path);
+}
+
+// write everything, or give up if the program has gone
+static void writeAll(int fd, char* buf, int len) {
+
+	ssize_t n;
+
+	while (len > 0) {
+		n = write(fd, buf, len);
+		if (n <= 0) {
+			printf("\n\nERROR: the program stopped reading its input\n\n");
+			exit(1);
+		}
+		buf = buf + n;
+		len = len - n;
+	}
+}
+
+// wait until there is room for another valid line in the send times
+static void waitForRoom(sender* S) {
+
+	struct timespec nap = {0, 10000};
+
+	while (S->valid - __atomic_load_n(&S->received, __ATOMIC_ACQUIRE) >= PENDING_SIZE)
+		nanosleep(&nap, NULL);
+}
+
+static void* sendThread(void* arg) {
+
+	sender* S = (sender*)arg;
+	workload* W = workload_create(&S->params);
+	char buf[SEND_CHUNK + WORKLOAD_MAX_LINE];
+	unsigned long int first = 0;	// the first valid line in buf
+	unsigned long int count = 0;
+	uint64_t start = nowNanos();
+	uint64_t due, t;
+	struct timespec ts;
+	int len = 0;
+	int n, valid;
+	unsigned long int i;
+
+	for (;;) {
+		n = workload_next(W, buf + len, &valid);
+
+		// Unpaced, the lines go out in pieces, and every line of a piece is
+		// sent when the piece is.
+		if (S->pace == 0) {
+			if (n == 0 || len + n > SEND_CHUNK) {
+				t = nowNanos();
+				for (i=first; i<S->valid; i++)
+					S->sent[i % PENDING_SIZE] = t;
+				writeAll(S->fd, buf, len);
+				first = S->valid;
+				memmove(buf, buf + len, n);
+				len = 0;
+			}
+			if (n == 0)
+				break;
+			len = len + n;
+			if (valid) {
+				waitForRoom(S);
+				S->valid++;
+			}
+			continue;
+		}
+
+		if (n == 0)
+			break;
+		due = start + (uint64_t)(count * 1e9 / S->pace);
+		count++;
+		t = nowNanos();
+		if (t < due) {
+			ts.tv_sec = due / 1000000000;
+			ts.tv_nsec = due % 1000000000;
+			clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+		}
+		if (valid) {
+			waitForRoom(S);
+			S->sent[S->valid % PENDING_SIZE] = due;
+			S->valid++;
+		}
+		writeAll(S->fd, buf, n);
+	}
+
+	workload_destroy(W);
+	close(S->fd);
+	return NULL;
+}
+
+static void runStream(workloadParams* P, double pace, char** args) {
+
+	int toProgram[2], fromProgram[2];
+	sender S;
+	pthread_t sendId;
+	histogram* H = calloc(1, sizeof(histogram));
+	char buf[1 << 16];
+	ssize_t n, i;
+	uint64_t start, t;
+	pid_t pid;
+	long int rss;
+
+	// The ends of the pipes are closed on exec, or the program would hold
+	// the other end of its own input open, and never see it end.
+	if (H == NULL || pipe2(toProgram, O_CLOEXEC) != 0 || pipe2(fromProgram, O_CLOEXEC) != 0) {
+		printf("\n\nFATAL ERROR: cannot set up the stream\n\n");
+		abort();
+	}
+
+	args[1] = "-";
+	args[2] = "-";
+	pid = launch(args, toProgram[0], fromProgram[1]);
+	close(toProgram[0]);
+	close(fromProgram[1]);
+
+	S.params = *P;
+	S.pace = pace;
+	S.fd = toProgram[1];
+	S.sent = malloc(PENDING_SIZE*sizeof(uint64_t));
+	S.received = 0;
+	S.valid = 0;
+	assert(S.sent != NULL);
+
+	start = nowNanos();
+	if (pthread_create(&sendId, NULL, sendThread, &S) != 0) {
+		printf("\n\nFATAL ERROR: the sender thread could not be started\n\n");
+		abort();
+	}
+
+	// every line of the output is the median of the next valid line
+	while ((n = read(fromProgram[0], buf, sizeof(buf))) > 0) {
+		t = nowNanos();
+		for (i=0; i<n; i++) {
+			if (buf[i] != '\n')
+				continue;
+			record(H, t - S.sent[S.received % PENDING_SIZE]);
+			__atomic_store_n(&S.received, S.received + 1, __ATOMIC_RELEASE);
+		}
+	}
+
+	pthread_join(sendId, NULL);
+	close(fromProgram[0]);
+	rss = finish(pid);
+
+	if (S.received != S.valid) {
+		printf("\n\nERROR: %lu medians came back for %lu valid lines\n\n", S.received, S.valid);
+		exit(1);
+	}
+	report("stream", P, (nowNanos() - start)*1e-9, H, rss);
+
+	free(S.sent);
+	free(H);
+}
+
+int main(int argc, char* argv[]) {
+
+	workloadParams P;
+	char* mode = "both";
+	char* windows = NULL;
+	double pace = 0;
+	char* args[7];
+	int opt;
+
+	workload_defaults(&P);
+	while ((opt = getopt(argc, argv, WORKLOAD_OPTIONS "m:p:w:H")) != -1) {
+		if (opt == 'm')
+			mode = optarg;
+		else if (opt == 'p')
+			pace = atof(optarg);
+		else if (opt == 'w')
+			windows = optarg;
+		else if (opt == 'H') {
+			printf("%-8s %12s %12s %10s %10s %10s %10s %10s %12s\n", "mode", "events", "events/s",
+				"p50_us", "p90_us", "p99_us", "p99.9_us", "max_us", "peak_rss_kb");
+			return 0;
+		}
+		else if (!workload_option(&P, opt, optarg)) {
+			printf("\n\nERROR: invalid option\n\n");
+			exit(1);
+		}
+	}
+	if (optind != argc - 1 || pace < 0) {
+		printf("\n\nERROR: give the path of the program last\n\n");
+		exit(1);
+	}
+
+	// if the program dies, writing to it fails rather than killing us
+	signal(SIGPIPE, SIG_IGN);
+
+	args[0] = argv[optind];
+	args[3] = "2";
+	args[4] = "0";
+	args[5] = windows;
+	args[6] = NULL;
+	if (windows == NULL)
+		args[3] = NULL;
+
+	if (strcmp(mode, "file") == 0 || strcmp(mode, "both") == 0)
+		runFile(&P, args);
+	if (strcmp(mode, "stream") == 0 || strcmp(mode, "both") == 0)
+		runStream(&P, pace, args);
+
+	return 0;
+}
@@ -0,0 +1,45 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "workload.h"
+
+// venGen writes a synthetic workload in the format of the input of the
+// challenge, to the file given as its last input, or to the standard output.
+// The options of the workload are listed in "workload.h", e.g.
+//   ./venGen -n 1000000 -u 50000 -s 1.2 -j 0.1 -J 60 big.txt
+
+int main(int argc, char* argv[]) {
+
+	workloadParams P;
+	workload* W;
+	FILE* fp_out = stdout;
+	char line[WORKLOAD_MAX_LINE];
+	int len, valid, opt;
+
+	workload_defaults(&P);
+	while ((opt = getopt(argc, argv, WORKLOAD_OPTIONS)) != -1) {
+		if (!workload_option(&P, opt, optarg)) {
+			printf("\n\nERROR: invalid option; the options are %s\n\n", WORKLOAD_OPTIONS);
+			exit(0);
+		}
+	}
+
+	if (optind < argc) {
+		fp_out = fopen(argv[optind], "w");
+		if (fp_out == NULL) {
+			printf("\n\nERROR: output file could not be opened\n\n");
+			exit(0);
+		}
+	}
+	setvbuf(fp_out, NULL, _IOFBF, 1 << 20);
+
+	W = workload_create(&P);
+	while ((len = workload_next(W, line, &valid)) > 0)
+		fwrite(line, 1, len, fp_out);
+	workload_destroy(W);
+
+	fclose(fp_out);
+	return 0;
+}
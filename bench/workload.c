@@ -0,0 +1,183 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+#include <assert.h>
+#include "workload.h"
+
+struct workloadPrototype {
+
+	workloadParams P;
+	unsigned long int count;	// lines generated so far
+
+	// cdf[r] is the total weight of the users of rank 0 to r
+	double* cdf;
+
+	uint64_t rng;
+
+	// the current time, in fractional seconds, and the time code of the
+	// last second formatted, so that strftime only runs when it changes
+	double now;
+	long int codeTime;
+	char code[32];
+};
+
+void workload_defaults(workloadParams* P) {
+	P->events = 1000000;
+	P->users = 100000;
+	P->skew = 1.0;
+	P->rate = 100;
+	P->jitterRatio = 0.05;
+	P->jitterMax = 30;
+	P->faultyRatio = 0.01;
+	P->startTime = 1459207392;	// the first time stamp of the sample input
+	P->seed = 1;
+}
+
+int workload_option(workloadParams* P, int opt, char* arg) {
+
+	char* end;
+	double x = strtod(arg, &end);
+
+	if (end == arg || *end != '\0' || x < 0)
+		return 0;
+
+	switch (opt) {
+		case 'n': P->events = (unsigned long int)x; break;
+		case 'u': P->users = (int)x; return P->users >= 2;
+		case 's': P->skew = x; break;
+		case 'r': P->rate = x; return x > 0;
+		case 'j': P->jitterRatio = x; return x <= 1;
+		case 'J': P->jitterMax = (int)x; break;
+		case 'f': P->faultyRatio = x; return x <= 1;
+		case 't': P->startTime = (unsigned long int)x; break;
+		case 'S': P->seed = (unsigned long int)x; break;
+		default: return 0;
+	}
+	return 1;
+}
+
+// xorshift64*, which is plenty for a workload and much faster than rand()
+static uint64_t nextRandom(workload* W) {
+	W->rng ^= W->rng >> 12;
+	W->rng ^= W->rng << 25;
+	W->rng ^= W->rng >> 27;
+	return W->rng * 0x2545F4914F6CDD1DULL;
+}
+
+// a uniform number in [0,1)
+static double uniform(workload* W) {
+	return (nextRandom(W) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+workload* workload_create(workloadParams* P) {
+
+	int r;
+	double total = 0;
+
+	assert(P->users >= 2 && P->rate > 0);
+
+	workload* W = malloc(sizeof(workload));
+	assert(W != NULL);
+
+	W->P = *P;
+	W->count = 0;
+	W->rng = P->seed*0x9E3779B97F4A7C15ULL + 1;
+	W->now = P->startTime;
+	W->codeTime = -1;
+
+	W->cdf = malloc(P->users*sizeof(double));
+	assert(W->cdf != NULL);
+	for (r=0; r<P->users; r++) {
+		total = total + pow(r + 1, -P->skew);
+		W->cdf[r] = total;
+	}
+
+	return W;
+}
+
+void workload_destroy(workload* W) {
+	free(W->cdf);
+	free(W);
+}
+
+// pick a user by activity, and return its id
+static int pickUser(workload* W) {
+
+	double x = uniform(W) * W->cdf[W->P.users - 1];
+	int lo = 0;
+	int hi = W->P.users - 1;
+	int mid;
+
+	while (lo < hi) {
+		mid = (lo + hi)/2;
+		if (W->cdf[mid] <= x)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	// The ranks are scattered over the ids, so that the most active users
+	// do not all have short names next to each other.
+	return (int)(((uint64_t)lo * 2654435761ULL) % W->P.users);
+}
+
+// the time code of a time stamp, like "2016-03-28T23:23:12Z"
+static char* timeCode(workload* W, long int t) {
+
+	struct tm tm;
+	time_t tt = t;
+
+	if (t != W->codeTime) {
+		gmtime_r(&tt, &tm);
+		strftime(W->code, sizeof(W->code), "%Y-%m-%dT%H:%M:%SZ", &tm);
+		W->codeTime = t;
+	}
+	return W->code;
+}
+
+int workload_next(workload* W, char* buf, int* valid) {
+
+	int actor, target;
+	long int t;
+	double r;
+
+	if (W->count == W->P.events)
+		return 0;
+	W->count++;
+
+	// the gaps between the events are exponential, as in a Poisson process
+	W->now = W->now - log(1 - uniform(W)) / W->P.rate;
+	t = (long int)W->now;
+	if (uniform(W) < W->P.jitterRatio)
+		t = t - (long int)(uniform(W) * (W->P.jitterMax + 1));
+
+	actor = pickUser(W);
+	do {
+		target = pickUser(W);
+	} while (target == actor);
+
+	// A faulty line is one of the kinds the parser rejects: a missing
+	// actor, an empty actor, a broken time code, or a cut off line.
+	*valid = 1;
+	r = uniform(W);
+	if (r < W->P.faultyRatio) {
+		*valid = 0;
+		switch ((int)(r / W->P.faultyRatio * 4)) {
+			case 0:
+				return sprintf(buf, "{\"created_time\": \"%s\", \"target\": \"user-%d\"}\n", timeCode(W, t), target);
+			case 1:
+				return sprintf(buf, "{\"created_time\": \"%s\", \"target\": \"user-%d\", \"actor\": \"\"}\n", timeCode(W, t), target);
+			case 2:
+				return sprintf(buf, "{\"created_time\": \"2016-0328T23:23:15Z\", \"target\": \"user-%d\", \"actor\": \"user-%d\"}\n", target, actor);
+			default:
+				return sprintf(buf, "{\"created_time\": \"%s\", \"target\": \"user-%d\", \"act\n", timeCode(W, t), target);
+		}
+	}
+
+	return sprintf(buf, "{\"created_time\": \"%s\", \"target\": \"user-%d\", \"actor\": \"user-%d\"}\n", timeCode(W, t), target, actor);
+}
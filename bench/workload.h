@@ -0,0 +1,53 @@
+#ifndef _workload_h
+#define _workload_h
+
+typedef struct workloadPrototype workload;
+
+// The parameters of a synthetic workload, in the format of the input of the
+// challenge. Every line is a payment between two users.
+typedef struct {
+	unsigned long int events;	// number of lines to generate
+	int users;					// number of distinct users
+
+	// The users are ranked by activity, and the user of rank r is picked
+	// with a probability proportional to 1/r^skew, so the degrees of the
+	// graph follow a power law. 0 picks every user equally often.
+	double skew;
+
+	double rate;				// events per second of time stamps, on average
+
+	// a jitterRatio of the events are given a time stamp up to jitterMax
+	// seconds older than the current time, i.e. they arrive out of order
+	double jitterRatio;
+	int jitterMax;
+
+	double faultyRatio;			// the ratio of faulty lines
+
+	unsigned long int startTime;	// the first time stamp, in seconds since the epoch
+	unsigned long int seed;
+} workloadParams;
+
+// the default parameters: a million events among 100000 users
+void workload_defaults(workloadParams* P);
+
+// The options of the workload on the command line, for getopt:
+//   -n events  -u users  -s skew  -r rate  -j jitterRatio  -J jitterMax
+//   -f faultyRatio  -t startTime  -S seed
+// workload_option sets the parameter of an option, and returns 0 if the
+// option is not one of these or its value is not valid.
+#define WORKLOAD_OPTIONS "n:u:s:r:j:J:f:t:S:"
+int workload_option(workloadParams* P, int opt, char* arg);
+
+// create and destroy a workload
+workload* workload_create(workloadParams* P);
+void workload_destroy(workload* W);
+
+// Write the next line of the workload, with its newline, into buf, which
+// holds at least WORKLOAD_MAX_LINE characters, and return its length.
+// valid is set to 1 if the program accepts the line, i.e. if it gets a line
+// of output, and to 0 if the line is faulty.
+// 0 is returned once all the events have been generated.
+#define WORKLOAD_MAX_LINE 256
+int workload_next(workload* W, char* buf, int* valid);
+
+#endif
@@ -1,5 +1,6 @@
 #!/usr/bin/env bash
 
-gcc -g -O0 -std=c99 -Wall -Wfloat-equal -Wtype-limits -Wpointer-arith -Wlogical-op src/venmoGraphParams.h src/list.h src/list.c src/table.h src/table.c src/main.c -o venGraph
+gcc -g -O0 -std=c99 -pthread -Wall -Wfloat-equal -Wtype-limits -Wpointer-arith -Wlogical-op src/venmoGraphParams.h src/pool.h src/pool.c src/degrees.h src/degrees.c src/ranking.h src/ranking.c src/list.h src/list.c src/table.h src/table.c src/intern.h src/intern.c src/expiry.h src/expiry.c src/edges.h src/edges.c src/parser.h src/parser.c src/reader.h src/reader.c src/writer.h src/writer.c src/ring.h src/ring.c src/instrument.h src/instrument.c src/reorder.h src/reorder.c src/eventlog.h src/eventlog.c src/snapshot.h src/snapshot.c src/engine.h src/engine.c src/main.c -o venGraph
+gcc -g -O0 -std=c99 -Wall -Wfloat-equal -Wtype-limits -Wpointer-arith -Wlogical-op src/venmoGraphParams.h src/pool.h src/pool.c src/table.h src/table.c src/parser.h src/parser.c src/reader.h src/reader.c src/instrument.h src/instrument.c src/eventlog.h src/eventlog.c src/venConvert.c -o venConvert
 
 ./venGraph venmo_input/venmo-trans.txt venmo_output/output.txt
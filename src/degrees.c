@@ -0,0 +1,189 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include "degrees.h"
+
+// The Fenwick tree stores at index i the number of nodes whose degree lies in
+// (i - lowbit(i), i], where lowbit(i) is the lowest set bit of i. So the range
+// of an index does not depend on the size of the tree. Doubling the size from
+// n to 2n leaves indices 1..n exactly as they are, the new indices n+1..2n-1
+// cover only degrees that nobody has yet (so they are 0), and index 2n covers
+// every degree, so it holds the total.
+// The tree is therefore stored in chunks that are never moved: chunk 0 holds
+// index 1, and chunk c holds indices 2^(c-1)+1 .. 2^c. Growing the tree
+// just allocates the next chunk.
+
+#define MAX_CHUNKS 32
+
+struct degreesPrototype {
+
+	int* chunks[MAX_CHUNKS];
+
+	int numChunks;
+
+	int size;	// the largest index, 2^(numChunks-1)
+
+	int count;	// the total of the histogram
+
+	// the journal of the changes, if one is kept (journalCap > 0)
+	int* journalDegs;
+	int* journalIncs;
+	int journalLen;
+	int journalCap;
+};
+
+#define INIT_JOURNAL_CAP 64
+
+// the cell of the tree at index i
+static int* cell(degrees* D, unsigned int i) {
+
+	// i-1 has c significant bits exactly when i is in chunk c
+	if (i == 1)
+		return &D->chunks[0][0];
+
+	int c = 32 - __builtin_clz(i - 1);
+	return &D->chunks[c][i - (1u << (c-1)) - 1];
+}
+
+// double the size of the tree
+static void grow(degrees* D) {
+
+	int c = D->numChunks;
+
+	if (c == MAX_CHUNKS) {
+		printf("\n\nFATAL ERROR: cannot expand the degree histogram\n\n");
+		abort();
+	}
+
+	// chunk c holds as many indices as the whole tree so far (except chunk 0)
+	D->chunks[c] = calloc(c == 0 ? 1 : D->size, sizeof(int));
+	assert(D->chunks[c] != NULL);
+
+	D->numChunks = c + 1;
+	D->size = (c == 0) ? 1 : D->size*2;
+
+	// the new last index covers every degree
+	*cell(D, D->size) = D->count;
+}
+
+degrees* degrees_create(int maxDegree) {
+
+	degrees* D = malloc(sizeof(degrees));
+	assert(D != NULL);
+
+	D->numChunks = 0;
+	D->size = 0;
+	D->count = 0;
+
+	D->journalDegs = NULL;
+	D->journalIncs = NULL;
+	D->journalLen = 0;
+	D->journalCap = 0;
+
+	do {
+		grow(D);
+	} while (D->size < maxDegree);
+
+	return D;
+}
+
+void degrees_destroy(degrees* D) {
+	
+	int c;
+	for (c=0; c<D->numChunks; c++)
+		free(D->chunks[c]);
+	free(D->journalDegs);
+	free(D->journalIncs);
+	free(D);
+}
+
+void degrees_add(degrees* D, int degree, int inc) {
+
+	assert(degree > 0);
+
+	while (degree > D->size)
+		grow(D);
+
+	// every index whose range contains the degree is found by adding the lowest set bit
+	unsigned int i = degree;
+	while (i <= (unsigned int)D->size) {
+		*cell(D, i) += inc;
+		i = i + (i & -i);
+	}
+
+	D->count = D->count + inc;
+
+	if (D->journalCap == 0)
+		return;
+
+	if (D->journalLen == D->journalCap) {
+		D->journalCap = D->journalCap*2;
+		D->journalDegs = realloc(D->journalDegs, D->journalCap*sizeof(int));
+		D->journalIncs = realloc(D->journalIncs, D->journalCap*sizeof(int));
+		if (D->journalDegs == NULL || D->journalIncs == NULL) {
+			printf("\n\nFATAL ERROR: cannot expand the journal of the degree histogram\n\n");
+			abort();
+		}
+	}
+	D->journalDegs[D->journalLen] = degree;
+	D->journalIncs[D->journalLen] = inc;
+	D->journalLen++;
+}
+
+void degrees_startJournal(degrees* D) {
+
+	if (D->journalCap > 0)
+		return;
+
+	D->journalCap = INIT_JOURNAL_CAP;
+	D->journalDegs = malloc(D->journalCap*sizeof(int));
+	D->journalIncs = malloc(D->journalCap*sizeof(int));
+	assert(D->journalDegs != NULL && D->journalIncs != NULL);
+	D->journalLen = 0;
+}
+
+int degrees_journal(degrees* D, int** degs, int** incs) {
+	*degs = D->journalDegs;
+	*incs = D->journalIncs;
+	return D->journalLen;
+}
+
+void degrees_clearJournal(degrees* D) {
+	D->journalLen = 0;
+}
+
+int degrees_count(degrees* D) {
+	return D->count;
+}
+
+// the chunks add up to exactly "size" cells
+size_t degrees_bytes(degrees* D) {
+	return sizeof(degrees) + ((size_t)D->size + 2*D->journalCap)*sizeof(int);
+}
+
+int degrees_select(degrees* D, int rank) {
+
+	// Descend from the largest power of 2. At every step we check whether
+	// the nodes of the next range all rank below the one we look for; if so
+	// we skip the whole range. pos ends as the largest degree with fewer than
+	// rank nodes at or below it, so the answer is the next degree.
+
+	assert(rank > 0 && rank <= D->count);
+
+	unsigned int pos = 0;
+	unsigned int step = D->size;
+	int c;
+
+	while (step > 0) {
+		if (pos + step <= (unsigned int)D->size) {
+			c = *cell(D, pos + step);
+			if (c < rank) {
+				pos = pos + step;
+				rank = rank - c;
+			}
+		}
+		step = step >> 1;
+	}
+
+	return pos + 1;
+}
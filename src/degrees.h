@@ -0,0 +1,44 @@
+#ifndef _degrees_h
+#define _degrees_h
+
+#include <stddef.h>
+
+typedef struct degreesPrototype degrees;
+
+// The histogram of the degrees of the nodes, i.e. for every degree the
+// number of nodes that have it. It is kept in a Fenwick tree, so both
+// updating a degree and finding the node of a given rank take O(log maxDegree).
+
+// create the histogram, with room for degrees up to maxDegree
+// the histogram grows by itself when a larger degree shows up
+degrees* degrees_create(int maxDegree);
+
+// destroy the histogram
+void degrees_destroy(degrees* D);
+
+// change the number of nodes with the given degree (at least 1) by inc
+void degrees_add(degrees* D, int degree, int inc);
+
+// the number of nodes in the histogram
+int degrees_count(degrees* D);
+
+// the bytes the histogram holds, its journal included
+size_t degrees_bytes(degrees* D);
+
+// the degree of the node of the given rank, counting from 1 for the lowest degree
+// the rank must be between 1 and degrees_count
+int degrees_select(degrees* D, int rank);
+
+// Keep a journal of the changes made to the histogram from now on, so that
+// they can be replayed into another histogram. The sharded graph (see main.c)
+// merges the histograms of its shards this way.
+void degrees_startJournal(degrees* D);
+
+// recover the changes recorded since the journal was last cleared
+// change i added incs[i] to the number of nodes of degree degs[i]
+int degrees_journal(degrees* D, int** degs, int** incs);
+
+// forget the changes recorded so far
+void degrees_clearJournal(degrees* D);
+
+#endif
@@ -0,0 +1,169 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <assert.h>
+#include "edges.h"
+#include "pool.h"
+
+#define MAX_LOAD 0.75
+
+// A cell of the index. The pair of ids is packed into one 64 bit key,
+// smaller id first, so that both orders of the same pair land on the
+// same cell.
+typedef struct edgeCell {
+
+	struct edgeCell* next;
+
+	uint64_t key;
+
+	void* item;
+} cell_t;
+
+struct edgesPrototype {
+
+	cell_t** cells;
+
+	int count_cells;	// always a power of 2
+	int count_elems;
+
+	pool* records;
+};
+
+// pack the unordered pair of ids into one key
+static uint64_t pairKey(uint32_t a, uint32_t b) {
+	if (a > b)
+		return ((uint64_t)b << 32) | a;
+	return ((uint64_t)a << 32) | b;
+}
+
+// hash of a key. the product is folded so that the high bits,
+// which depend on both ids, pick the cell
+static unsigned int hashKey(uint64_t key, int nCells) {
+	uint64_t h = key * 0x9E3779B97F4A7C15ULL;
+	h = h ^ (h >> 32);
+	return (unsigned int)(h & (uint64_t)(nCells - 1));
+}
+
+edges* edges_create(int initCapacity) {
+
+	edges* E = malloc(sizeof(edges));
+	assert(E != NULL);
+
+	E->count_cells = 1;
+	while (E->count_cells < initCapacity)
+		E->count_cells = E->count_cells*2;
+
+	E->count_elems = 0;
+
+	E->cells = calloc(E->count_cells, sizeof(cell_t*));
+	assert(E->cells != NULL);
+
+	E->records = pool_create(sizeof(cell_t));
+
+	return E;
+}
+
+void edges_destroy(edges* E) {
+	pool_destroy(E->records);
+	free(E->cells);
+	free(E);
+}
+
+int edges_count(edges* E) {
+	return E->count_elems;
+}
+
+size_t edges_bytes(edges* E) {
+	return sizeof(edges) + (size_t)E->count_cells*sizeof(cell_t*) + pool_bytes(E->records);
+}
+
+// double the number of cells and relink every cell into its new chain.
+// if the reallocation cannot be performed, the index is used in its old form
+static void edges_rehash(edges* E) {
+
+	int nCells = E->count_cells*2;
+	cell_t** newCells = calloc(nCells, sizeof(cell_t*));
+
+	if (newCells == NULL)
+		return;
+
+	int i;
+	unsigned int h;
+	cell_t* a;
+	cell_t* b;
+
+	for (i=0; i<E->count_cells; i++) {
+		a = E->cells[i];
+		while (a != NULL) {
+			b = a->next;
+			h = hashKey(a->key, nCells);
+			a->next = newCells[h];
+			newCells[h] = a;
+			a = b;
+		}
+	}
+	free(E->cells);
+	E->cells = newCells;
+	E->count_cells = nCells;
+}
+
+void* edges_get(edges* E, uint32_t idA, uint32_t idT) {
+
+	uint64_t key = pairKey(idA, idT);
+
+	cell_t* a = E->cells[hashKey(key, E->count_cells)];
+
+	while (a != NULL) {
+		if (a->key == key)
+			return a->item;
+		a = a->next;
+	}
+	return NULL;
+}
+
+void edges_put(edges* E, uint32_t idA, uint32_t idT, void* item) {
+
+	uint64_t key = pairKey(idA, idT);
+
+	unsigned int h = hashKey(key, E->count_cells);
+	cell_t* a = E->cells[h];
+
+	while (a != NULL) {
+		if (a->key == key) {
+			a->item = item;
+			return;
+		}
+		a = a->next;
+	}
+
+	a = pool_alloc(E->records);
+
+	a->key = key;
+	a->item = item;
+	a->next = E->cells[h];
+	E->cells[h] = a;
+
+	E->count_elems = E->count_elems + 1;
+
+	if ((float)E->count_elems > MAX_LOAD*(float)E->count_cells)
+		edges_rehash(E);
+}
+
+void edges_remove(edges* E, uint32_t idA, uint32_t idT) {
+
+	uint64_t key = pairKey(idA, idT);
+
+	cell_t** p = &E->cells[hashKey(key, E->count_cells)];
+	cell_t* a = *p;
+
+	while (a != NULL) {
+		if (a->key == key) {
+			*p = a->next;
+			pool_free(E->records, a);
+			E->count_elems = E->count_elems - 1;
+			return;
+		}
+		p = &a->next;
+		a = a->next;
+	}
+}
@@ -0,0 +1,33 @@
+#ifndef _edges_h
+#define _edges_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef struct edgesPrototype edges;
+
+// create the edge index by specifying the initial number of cells
+edges* edges_create(int initCapacity);
+
+// destroy the index (the items are not freed, they belong to the caller)
+void edges_destroy(edges* E);
+
+// recover the number of edges in the index
+int edges_count(edges* E);
+
+// the bytes the index holds: its cells and its records
+size_t edges_bytes(edges* E);
+
+// a branch is identified by the unordered pair of the ids of its nodes,
+// so (A,T) and (T,A) are the same branch.
+
+// get the item stored for the branch between A and T, or NULL if there is none
+void* edges_get(edges* E, uint32_t idA, uint32_t idT);
+
+// store an item for the branch between A and T, replacing any previous item
+void edges_put(edges* E, uint32_t idA, uint32_t idT, void* item);
+
+// remove the branch between A and T. if it is not found, the index is unchanged
+void edges_remove(edges* E, uint32_t idA, uint32_t idT);
+
+#endif
@@ -0,0 +1,844 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+#include <assert.h>
+#include "engine.h"
+#include "list.h"
+#include "intern.h"
+#include "expiry.h"
+#include "edges.h"
+#include "table.h"
+#include "instrument.h"
+#include "venmoGraphParams.h"
+
+// The graph and the bookkeeping that goes along with it.
+// In the pipeline (see main.c) it belongs to the graph thread alone.
+struct enginePrototype {
+	intern* NODES;	// the names of the nodes, interned to dense ids
+	List* LG;		// the lists of all the nodes, indexed by id
+	expiry* EXP;	// expiry index of the branches, one bucket per second of the window
+	edges* EDG;		// edge index, which finds the branch between two nodes directly
+	
+	// the current maximum time stamp
+	unsigned long int maxTime;
+	
+	// The windows. The graph itself is kept for the longest one, maxAge,
+	// which is window 0 of the lists, and the lists keep the degrees of
+	// the nodes in the shorter ones as well (see list.h).
+	// Window w of the lists is age[w] seconds long, and every branch older
+	// than cursor[w] has left it (the expiry index keeps the cursor of
+	// window 0 itself). column[c] is the window of the lists
+	// whose median goes into column c of the output.
+	windowSet windows;
+	unsigned long int maxAge;
+	int numWindows;
+	unsigned long int age[MAX_WINDOWS];
+	unsigned long int cursor[MAX_WINDOWS];
+	int column[MAX_WINDOWS];
+	
+	// In the sharded graph (see main.c), the shard this graph is, out of
+	// numShards. Otherwise numShards is 1.
+	int shard;
+	int numShards;
+	
+	int medianAlg;			// 1 for the naiveMedian algorithm, 2 for the fast one
+	float medianCompTime;	// the time the computer takes to compute the
+							// median. useful for comparing the algorithms.
+	
+	int entryCounter;	// Increases after every line that enters the graph
+	int printEntry;		// After which entry to print the graph
+	
+	// The statistics after the last event, which hold as long as no degree
+	// changes. changed is set whenever a degree may have changed.
+	statsLine last;
+	int changed;
+	
+	// the memory budget (0 for none), and what it has cost (see engineMemory)
+	size_t budget;
+	size_t peak;
+	unsigned long int evicted;
+	unsigned long int rejected;
+};
+
+// put a branch from the owner to the name in the list of the owner,
+// register its time stamp in the expiry index, and register the expiry
+// entry under the pair of nodes in the edge index.
+// the expiry entry, and with it the time stamp, is the datum of the list
+// block itself, so putting a branch allocates nothing but the block.
+static void putBranch(expiry* E, edges* EDG, List* L, uint32_t owner, uint32_t name, unsigned long int time) {
+	void* entry = List_getDatum(List_put(L, owner, name, NULL));
+	expiry_add(E, entry, time, owner);
+	edges_put(EDG, owner, name, entry);
+}
+
+// take the branch of an expiry entry, which is already out of the index,
+// out of the graph, along with any node it leaves without branches
+static void removeBranch(intern* I, List* L, edges* EDG, void* entry) {
+
+	// Variable naming convention: 
+	// the node whose list records the branch is the "owner"
+	// the node at the other end of the branch is the "name" in the block
+	uint32_t owner = expiry_getOwner(entry);
+	void* curBlock = List_getBlockOfDatum(entry);
+	
+	// The name in the block is the id of the other node, so its
+	// lengths are found directly in the arrays of L.
+	// the branch is removed from the graph when the actual length of the list is decremented
+	// and if the actual length falls to 0, we can immediately remove BOTH nodes at the same time
+	
+	uint32_t name = List_getName(curBlock);
+	List_incLenAct(L, name, -1);
+	if (List_lenAct(L, name) == 0) {
+		intern_remove(I, name);
+		INSTR_COUNT(COUNT_NODES_REMOVED, 1);
+	}
+	List_remove(L, owner, curBlock);
+	edges_remove(EDG, owner, name);
+	
+	// If the owner has no branches left, remove it too
+	if (List_lenAct(L, owner) == 0) {
+		intern_remove(I, owner);
+		INSTR_COUNT(COUNT_NODES_REMOVED, 1);
+	}
+}
+
+// update the graph by removing branches whose timestamps are
+// too old and nodes which have no branches
+// maxTime is the current maximum time stamp (this may not be the time
+// stamp of the current entry, as entries need not arrive chronologically) 
+// and maxAge the longest window
+static void updateGraph(intern* I, List* L, expiry* E, edges* EDG, unsigned long int maxTime, unsigned long int maxAge) {
+
+	// Alg: take the expired branches out of the expiry index one by one.
+	// The index is a ring of one second buckets, so only the branches that
+	// actually fell out of the window are visited, not every node.
+	
+	void* entry;
+	
+	// a branch is too old if maxTime - time > maxAge,
+	// i.e. if its time is older than maxTime - maxAge
+	if (maxTime <= maxAge)
+		return;
+	
+	unsigned long int oldest = maxTime - maxAge;
+	
+	while ((entry = expiry_pop(E, oldest)) != NULL) {
+		removeBranch(I, L, EDG, entry);
+		INSTR_COUNT(COUNT_EXPIRED, 1);
+	}
+}
+
+// integer sorter used by qsort for the naive median algorithm
+static int intCmpFn (const void * a, const void * b) {
+   return ( *(int*)a - *(int*)b );
+}
+
+// the naive median, explained in the readme, of the degrees in window w
+// of the lists (see list.h)
+static float naiveMedian(intern* I, List* L, int w) {
+
+	int n = 0;
+
+	// array whose elements will be the list lengths (vertex degrees)
+	float* lenArr = malloc(intern_count(I)*sizeof(float));
+	float median;
+	
+	// go through all the ids in use, get the degree of each
+	// a node can have no branches in a shorter window, in which case it is
+	// not a node of the graph of that window
+	uint32_t id;
+	for (id=0; id<intern_capacity(I); id++) {
+		if (intern_getName(I, id) != NULL && List_lenWindow(L, w, id) > 0) {
+			lenArr[n] = (float)List_lenWindow(L, w, id);
+			n++;
+		}
+	}
+	
+	if (n == 0) {
+		free(lenArr);
+		return 0;
+	}
+	
+	// sort the array
+	qsort(lenArr, n, sizeof(int), intCmpFn);
+	
+	// get the middle number (median)
+	if (n % 2) {
+		median = ( lenArr[(n-1)/2] );
+	}
+	else {
+		int ind = n/2;
+		median = ( (lenArr[ind]+lenArr[ind-1])/2 );
+	}	
+	free(lenArr);
+	return median;
+}
+
+// fast median algorithm
+// the histogram holds the degrees of all the nodes in the graph
+float engine_fastMedian(degrees* D) {
+
+	// The algorithm is explained in detail in the readme.
+	// The histogram finds the degree of a given rank directly,
+	// so the median is the degree in the middle, or the mean of
+	// the two degrees in the middle if the number of nodes is even.
+	// All the counting is done in integers.
+	
+	// 0 is returned if the graph is empty. 
+
+	int tot = degrees_count(D);
+	
+	if (tot == 0)
+		return 0;
+	
+	if (tot % 2)
+		return (float)degrees_select(D, (tot+1)/2);
+	
+	return ((float)(degrees_select(D, tot/2) + degrees_select(D, tot/2 + 1)))/2;
+}
+
+// collect the statistics of the current graph from the histogram of its
+// degrees, and from the ranking and the names of its nodes if TOP_K > 0
+static void collectStats(degrees* D, ranking* R, intern* I, float median, statsLine* S) {
+
+	// The quantiles come from the histogram, just like the median, and the
+	// nodes of the highest degrees from the ranking, so nothing is sorted.
+	// The quantile p is the degree of rank ceil(p*n).
+
+	S->numMedians = 1;
+	S->medians[0] = median;
+	S->numTop = 0;
+	S->memory = 0;
+	
+	if (NUM_QUANTILES == 0 && TOP_K == 0)
+		return;
+	
+	static const double quantiles[] = QUANTILES;
+	uint32_t topIds[TOP_K + 1];
+	
+	int n = degrees_count(D);
+	int i, rank;
+	char* name;
+	
+	for (i=0; i<NUM_QUANTILES; i++) {
+		rank = (int)(quantiles[i]*n);
+		if (rank < quantiles[i]*n)
+			rank++;
+		if (rank < 1)
+			rank = 1;
+		if (rank > n)
+			rank = n;
+		S->quantiles[i] = (n == 0 ? 0 : degrees_select(D, rank));
+	}
+	
+	if (TOP_K == 0)
+		return;
+	
+	S->numTop = ranking_top(R, D, TOP_K, topIds, S->topDegs);
+	for (i=0; i<S->numTop; i++) {
+		name = intern_getName(I, topIds[i]);
+		S->topLens[i] = strlen(name);
+		memcpy(S->topNames[i], name, S->topLens[i]);
+	}
+}
+
+// Graph printer
+static void printGraph(intern* I, List* L) {
+
+	// Prints the entire graph. The format is explained in the
+	// readme. An example is also shown. 
+	// The printer is useful for debugging, and it can be called
+	// by the user with the fourth argument to the executable.
+
+	printf("\n\n*************************\n");
+	printf("******PRINTING GRAPH*****\n\n");
+	
+	printf("There are %d nodes in the graph\n",intern_count(I));
+	
+	void* block;
+	char* key;
+	unsigned long int timeStamp;
+	uint32_t id;
+	int j;
+	
+	// iterate through all the ids in use (nodes)
+	for (id=0; id<intern_capacity(I); id++) {
+	
+		key = intern_getName(I, id);
+		if (key == NULL)
+			continue;
+		
+		// Print the name and list lengths
+		printf("List %s:\tlenRec = %d,\tlenAct = %d\n",key,List_lenRec(L,id),List_lenAct(L,id));
+		
+		block = List_firstBlock(L, id);
+		
+		// iterate through the list of the user and print the
+		// timestamp and name of everyone with whom that user 
+		// has traded and who is actually recorded in the list.
+		printf("\tList contents\n");
+		for(j=0; j<List_lenRec(L,id); j++) {
+			
+			timeStamp = expiry_getTime(List_getDatum(block));
+			printf("\t\tTarget %s @ %ld\n",intern_getName(I, List_getName(block)),timeStamp);
+			
+			block = List_nextBlock(block);
+		}
+	
+		printf("------------------------------\n");
+	}
+}
+
+// give the graph empty structures
+// the nodes of the graph: the names are interned to dense ids,
+// and the lists of all the nodes are kept in arrays indexed by id
+engine* engine_create(windowSet* W, int medianAlg, int printEntry) {
+
+	int c, w;
+	
+	engine* G = malloc(sizeof(engine));
+	assert(G != NULL);
+	
+	// The longest window is window 0 of the lists, and the columns of the
+	// same length share a window.
+	G->windows = *W;
+	G->maxAge = 0;
+	for (c=0; c<W->count; c++) {
+		if (W->ages[c] > G->maxAge)
+			G->maxAge = W->ages[c];
+	}
+	G->numWindows = 1;
+	G->age[0] = G->maxAge;
+	G->cursor[0] = 0;
+	for (c=0; c<W->count; c++) {
+		for (w=0; w<G->numWindows && G->age[w] != W->ages[c]; w++)
+			;
+		if (w == G->numWindows) {
+			G->age[w] = W->ages[c];
+			G->cursor[w] = 0;
+			G->numWindows++;
+		}
+		G->column[c] = w;
+	}
+	
+	G->NODES = intern_create(INITIAL_TABLE_SIZE);
+	G->LG = List_create(expiry_entrySize(), INITIAL_TABLE_SIZE, NULL);
+	if (TOP_K > 0)
+		List_enableRanking(G->LG);
+	List_addWindows(G->LG, G->numWindows - 1);
+	
+	G->EXP = expiry_create(G->maxAge + 1);
+	G->EDG = edges_create(INITIAL_TABLE_SIZE);
+	
+	G->maxTime = 0;
+	G->shard = 0;
+	G->numShards = 1;
+	G->medianAlg = medianAlg;
+	G->medianCompTime = 0;
+	G->entryCounter = 1;
+	G->printEntry = printEntry;
+	G->changed = 1;
+	
+	G->budget = 0;
+	G->peak = 0;
+	G->evicted = 0;
+	G->rejected = 0;
+	
+	return G;
+}
+
+void engine_destroy(engine* G) {
+	intern_destroy(G->NODES);
+	List_destroy(G->LG);
+	expiry_destroy(G->EXP);
+	edges_destroy(G->EDG);
+	free(G);
+}
+
+// seconds of processor time used by the calling thread
+// (clock() would also count the other threads of the pipeline)
+static double threadSeconds() {
+	struct timespec ts;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+	return ts.tv_sec + ts.tv_nsec*1e-9;
+}
+
+// compute the median of the degrees in window w of the lists with the
+// chosen algorithm, and time it
+static float computeMedian(engine* G, int w) {
+
+	double timeBeg, timeEnd;
+	float median = 0;
+	
+	timeBeg = threadSeconds();
+	if (G->medianAlg == 1)
+		median = naiveMedian(G->NODES, G->LG, w);
+	if (G->medianAlg == 2)
+		median = engine_fastMedian(List_windowDegrees(G->LG, w));
+	timeEnd = threadSeconds();
+	
+	G->medianCompTime = G->medianCompTime + (float)(timeEnd - timeBeg);
+	return median;
+}
+
+// the shard of the sharded graph that a name belongs to
+// the slots of the tables are picked with the low bits of the hash, so the
+// shard is picked with the high bits, or the nodes of a shard would all
+// crowd into the same slots of its tables
+int engine_shardOf(char* name, int len, int numShards) {
+	return (int)((table_hash(name, len) >> 32) % numShards);
+}
+
+// give a new node an empty list
+// in a shard, a node of another shard is only a ghost (see list.h)
+static void addNode(engine* G, uint32_t id, nameView* name) {
+	if (G->numShards > 1 && engine_shardOf(name->str, name->len, G->numShards) != G->shard)
+		List_addGhost(G->LG, id);
+	else
+		List_addNode(G->LG, id);
+}
+
+// start an empty graph at the given max time, as if it had seen the events
+// before, and they had all expired
+void engine_startAt(engine* G, unsigned long int time) {
+
+	int w;
+	
+	G->maxTime = time;
+	for (w=0; w<G->numWindows; w++)
+		G->cursor[w] = (time > G->age[w]) ? time - G->age[w] : 0;
+	expiry_start(G->EXP, G->cursor[0]);
+}
+
+// A branch that falls out of a shorter window stays in the graph, since it
+// is still in the longest one. Only the degrees of its two nodes in that
+// window go down.
+typedef struct {
+	List* L;
+	int w;
+} windowExit;
+
+static void leaveWindow(void* ctx, void* entry) {
+	windowExit* X = (windowExit*)ctx;
+	List_incWindow(X->L, X->w, expiry_getOwner(entry), -1);
+	List_incWindow(X->L, X->w, List_getName(List_getBlockOfDatum(entry)), -1);
+}
+
+// The branch between A and T now has the time stamp "time". It enters every
+// shorter window that reaches back to it, unless it was already in it: a
+// branch that is not new was in the windows its old time stamp was not
+// behind the cursor of.
+static void enterWindows(engine* G, uint32_t idA, uint32_t idT, int isNew, unsigned long int oldTime, unsigned long int time) {
+
+	int w;
+	
+	for (w=1; w<G->numWindows; w++) {
+		if (time >= G->cursor[w] && (isNew || oldTime < G->cursor[w])) {
+			List_incWindow(G->LG, w, idA, 1);
+			List_incWindow(G->LG, w, idT, 1);
+			G->changed = 1;
+		}
+	}
+}
+
+// If the timestamp is the most recent in calendar time, update the
+// max time and prune the branches that fell out of the windows. 
+// If the max time did not advance, nothing can have expired.
+void engine_advance(engine* G, unsigned long int time) {
+
+	windowExit X;
+	int w;
+	
+	if (time > G->maxTime) {
+		INSTR_START(t);
+		G->maxTime = time;
+		G->changed = 1;
+		
+		// The shorter windows go first, while every branch they pass over
+		// is still in the expiry index.
+		X.L = G->LG;
+		for (w=1; w<G->numWindows; w++) {
+			if (G->maxTime > G->age[w]) {
+				X.w = w;
+				expiry_pass(G->EXP, &G->cursor[w], G->maxTime - G->age[w], leaveWindow, &X);
+			}
+		}
+		
+		updateGraph(G->NODES, G->LG, G->EXP, G->EDG, G->maxTime, G->maxAge);
+		INSTR_STOP(STAGE_EXPIRE, t);
+	}
+}
+
+// the total of engineMemory
+static size_t graphBytes(engine* G) {
+	return intern_bytes(G->NODES) + List_headerBytes(G->LG) + List_blockBytes(G->LG)
+		+ expiry_bytes(G->EXP) + edges_bytes(G->EDG);
+}
+
+// Early eviction (see engine_setBudget). While the graph holds its budget or
+// more, its oldest branch is taken out, as if it had expired, along with its
+// degrees in the shorter windows it is still in. The expiry index moves on
+// to the second of the branch, so an event older than that is behind the
+// index, and is kept out of the graph like an event older than the window.
+// This comes before the ids of the nodes of the event are looked up, since
+// it may remove them.
+// 0 is returned if the event at the given time cannot go into the graph.
+static int keepBudget(engine* G, unsigned long int time) {
+
+	windowExit X;
+	void* entry;
+	size_t bytes = graphBytes(G);
+	int w;
+	
+	if (bytes > G->peak)
+		G->peak = bytes;
+	
+	X.L = G->LG;
+	while (bytes >= G->budget) {
+		entry = expiry_pop(G->EXP, G->maxTime + 1);
+		if (entry == NULL)
+			return 0;
+		for (w=1; w<G->numWindows; w++) {
+			if (expiry_getTime(entry) >= G->cursor[w]) {
+				X.w = w;
+				leaveWindow(&X, entry);
+			}
+		}
+		removeBranch(G->NODES, G->LG, G->EDG, entry);
+		G->evicted++;
+		G->changed = 1;
+		INSTR_COUNT(COUNT_EVICTED, 1);
+		bytes = graphBytes(G);
+	}
+	return (time >= expiry_cursor(G->EXP));
+}
+
+// advance the max time to the time stamp of a valid event of the input
+// 0 is returned if the event is too old to go into the graph
+int engine_admit(engine* G, unsigned long int time) {
+
+	// The graph must be updated BEFORE the ids of A and T 
+	// are looked up, as the update may remove them.
+	engine_advance(G, time);
+	
+	// If the timestamp is too old, the median is recorded, 
+	// but we don't bother updating the graph
+	// An event that is only too old for the shorter windows still goes into
+	// the graph, outside of those windows.
+	if (G->maxTime - time > G->maxAge) {
+		INSTR_COUNT(COUNT_TOO_OLD, 1);
+		return 0;
+	}
+	if (G->budget > 0 && !keepBudget(G, time)) {
+		G->rejected++;
+		INSTR_COUNT(COUNT_REJECTED, 1);
+		return 0;
+	}
+	return 1;
+}
+
+// get the id of a name. If the name is not a node yet,
+// intern it and give it an empty list.
+uint32_t engine_node(engine* G, nameView* name) {
+
+	uint32_t id = intern_get(G->NODES, name->str, name->len);
+	
+	if (id == INTERN_NONE) {
+		id = intern_put(G->NODES, name->str, name->len);
+		addNode(G, id, name);
+		INSTR_COUNT(COUNT_NODES_ADDED, 1);
+	}
+	return id;
+}
+
+// put the branch between the actor A and the target T into the graph, or
+// give it the time stamp of the event if that is newer
+void engine_link(engine* G, uint32_t idA, uint32_t idT, unsigned long int time) {
+
+	void* checkEntry;
+	unsigned long int oldTime;
+	
+	// Now we want to check if A and T already have a branch between them.
+	// The edge index returns its expiry entry directly, without going
+	// down the lists of A and T.
+	// If the branch exists and the current timestamp is more recent,
+	// we move the branch to the current timestamp. Its list block
+	// does not move, since the lists are not sorted chronologically.
+	// Otherwise we put T in A.
+	
+	INSTR_START(tInsert);
+	checkEntry = edges_get(G->EDG, idA, idT);
+	
+	if (checkEntry == NULL) {
+		putBranch(G->EXP, G->EDG, G->LG, idA, idT, time);
+		List_incLenAct(G->LG, idT, 1);
+		enterWindows(G, idA, idT, 1, 0, time);
+		G->changed = 1;
+		INSTR_COUNT(COUNT_NEW_BRANCHES, 1);
+	}
+	else if (time > expiry_getTime(checkEntry)) {
+		oldTime = expiry_getTime(checkEntry);
+		expiry_touch(G->EXP, checkEntry, time);
+		enterWindows(G, idA, idT, 0, oldTime, time);
+		INSTR_COUNT(COUNT_REFRESHED, 1);
+	}
+	INSTR_STOP(STAGE_INSERT, tInsert);
+	
+	if (G->printEntry == G->entryCounter) {
+		printGraph(G->NODES, G->LG);
+		printf("\n\n");
+	}
+	
+	G->entryCounter++;
+}
+
+// apply a valid event of the input to the graph
+void engine_apply(engine* G, venmoEvent* ev) {
+
+	uint32_t idA;	// actor id
+	uint32_t idT;	// target id
+	
+	if (!engine_admit(G, ev->time))
+		return;
+	
+	// A = actor
+	// T = target
+	
+	INSTR_START(tLookup);
+	idA = engine_node(G, &ev->actor);
+	idT = engine_node(G, &ev->target);
+	INSTR_STOP(STAGE_LOOKUP, tLookup);
+	
+	engine_link(G, idA, idT, ev->time);
+}
+
+// collect the statistics of the graph after an event
+// every window gets a median, and the other statistics are those of the
+// longest window, which is the graph itself
+// If no degree has changed since the last time, neither have the statistics.
+// A refreshed branch or an event that is too old changes no degree, so on a
+// stream where the same pairs trade again and again most of the medians are
+// simply copied.
+void engine_stats(engine* G, statsLine* S) {
+
+	int c;
+	
+	INSTR_START(t);
+	if (G->changed) {
+		collectStats(List_degrees(G->LG), List_ranking(G->LG), G->NODES, computeMedian(G, G->column[0]), &G->last);
+		
+		for (c=1; c<G->windows.count; c++)
+			G->last.medians[c] = computeMedian(G, G->column[c]);
+		G->last.numMedians = G->windows.count;
+		G->changed = 0;
+	}
+	*S = G->last;
+	if (REPORT_MEMORY)
+		S->memory = graphBytes(G);
+	INSTR_STOP(STAGE_MEDIAN, t);
+}
+
+void engine_ingest(engine* G, venmoEvent* ev, statsLine* S) {
+	engine_apply(G, ev);
+	engine_stats(G, S);
+}
+
+// A run of a batch: events that can all meet the largest max time among
+// them, so that the max time advances once for the whole run and the
+// expired branches are pruned once. Every event must then see the graph it
+// would see alone, which holds as long as
+// - no event of the run is older than that max time by more than the
+//   shortest window, so none of them falls out of a window (or is too old)
+//   where it would not have alone, and
+// - no branch already in the graph has a time stamp that the max time of
+//   the run would prune, or take out of a shorter window, but the max time
+//   of the first event would not, so no branch leaves early.
+// The length of the run from evs[0] on is returned, at least 1, and its
+// max time goes into *top. Under a memory budget the graph is pruned event
+// by event, so every run is a single event.
+static int runLength(engine* G, venmoEvent* evs, int n, unsigned long int* top) {
+
+	unsigned long int shortest = G->maxAge;
+	unsigned long int least = evs[0].time;
+	unsigned long int newTop, newLeast;
+	int k, w;
+	
+	*top = (evs[0].time > G->maxTime) ? evs[0].time : G->maxTime;
+	if (G->budget > 0)
+		return 1;
+	
+	for (w=1; w<G->numWindows; w++) {
+		if (G->age[w] < shortest)
+			shortest = G->age[w];
+	}
+	
+	for (k=1; k<n; k++) {
+		newTop = (evs[k].time > *top) ? evs[k].time : *top;
+		newLeast = (evs[k].time < least) ? evs[k].time : least;
+		if (newTop - newLeast > shortest)
+			break;
+		
+		// the seconds that the max time of the run moves past
+		for (w=0; w<G->numWindows; w++) {
+			if (newTop > G->age[w] && expiry_within(G->EXP, (*top > G->age[w]) ? *top - G->age[w] : 0, newTop - G->age[w]))
+				break;
+		}
+		if (w < G->numWindows)
+			break;
+		
+		*top = newTop;
+		least = newLeast;
+	}
+	return k;
+}
+
+void engine_ingestBatch(engine* G, venmoEvent* evs, int n, statsLine* out) {
+
+	unsigned long int top;
+	int i, k, len;
+	
+	for (i=0; i<n; i=i+len) {
+		len = runLength(G, &evs[i], n - i, &top);
+		engine_advance(G, top);
+		for (k=i; k<i+len; k++) {
+			engine_apply(G, &evs[k]);
+			engine_stats(G, &out[k]);
+		}
+	}
+}
+
+char* engine_nodeName(engine* G, uint32_t id) {
+	return intern_getName(G->NODES, id);
+}
+
+unsigned long int engine_maxTime(engine* G) {
+	return G->maxTime;
+}
+
+unsigned long int engine_maxAge(engine* G) {
+	return G->maxAge;
+}
+
+windowSet* engine_windows(engine* G) {
+	return &G->windows;
+}
+
+int engine_numWindows(engine* G) {
+	return G->numWindows;
+}
+
+int engine_medianAlg(engine* G) {
+	return G->medianAlg;
+}
+
+float engine_medianTime(engine* G) {
+	return G->medianCompTime;
+}
+
+void engine_setBudget(engine* G, size_t bytes) {
+	G->budget = bytes;
+}
+
+void engine_memory(engine* G, engineMemory* M) {
+	M->names = intern_bytes(G->NODES);
+	M->lists = List_headerBytes(G->LG);
+	M->blocks = List_blockBytes(G->LG);
+	M->expiry = expiry_bytes(G->EXP);
+	M->edges = edges_bytes(G->EDG);
+	M->total = M->names + M->lists + M->blocks + M->expiry + M->edges;
+	M->budget = G->budget;
+	M->peak = G->peak;
+	M->evicted = G->evicted;
+	M->rejected = G->rejected;
+}
+
+void engine_setShard(engine* G, int shard, int numShards) {
+	G->shard = shard;
+	G->numShards = numShards;
+}
+
+degrees* engine_degrees(engine* G) {
+	return List_degrees(G->LG);
+}
+
+void engine_degreeStats(degrees* D, float median, statsLine* S) {
+	collectStats(D, NULL, NULL, median, S);
+}
+
+// fill in what a snapshot records besides the graph
+static void snapshotInfoOf(engine* G, long long int offset, unsigned long int lines, snapshotInfo* info) {
+
+	int c;
+	
+	info->maxTime = G->maxTime;
+	info->numWindows = G->windows.count;
+	for (c=0; c<G->windows.count; c++)
+		info->ages[c] = G->windows.ages[c];
+	info->inputOffset = offset;
+	info->lines = lines;
+	info->entryCounter = G->entryCounter;
+}
+
+pid_t engine_forkSnapshot(engine* G, char* path, long long int offset, unsigned long int lines) {
+
+	snapshotInfo info;
+	
+	snapshotInfoOf(G, offset, lines, &info);
+	return snapshot_fork(path, &info, G->NODES, G->LG);
+}
+
+int engine_writeSnapshot(engine* G, char* path, long long int offset, unsigned long int lines) {
+
+	snapshotInfo info;
+	
+	snapshotInfoOf(G, offset, lines, &info);
+	return snapshot_write(path, &info, G->NODES, G->LG);
+}
+
+int engine_restore(engine* G, snapshot* S) {
+
+	snapshotInfo* info = snapshot_info(S);
+	snapshotBranch* B;
+	unsigned long int b, numBranches;
+	uint32_t* ids;
+	uint32_t id, owner, name;
+	nameView node;
+	int c;
+	
+	if (info->numWindows != G->windows.count)
+		return 0;
+	for (c=0; c<G->windows.count; c++) {
+		if (info->ages[c] != G->windows.ages[c])
+			return 0;
+	}
+	
+	// The graph starts at the max time of the snapshot, and its branches
+	// are put back just as their events put them in first: each one enters
+	// every window that reaches back to its time stamp. So the degrees, the
+	// histograms and the expiry index all come out as they were.
+	engine_startAt(G, info->maxTime);
+	
+	ids = malloc((snapshot_numIds(S) + 1)*sizeof(uint32_t));
+	assert(ids != NULL);
+	while (snapshot_nextNode(S, &id, &node))
+		ids[id] = engine_node(G, &node);
+	
+	B = snapshot_branches(S);
+	numBranches = snapshot_numBranches(S);
+	for (b=0; b<numBranches; b++) {
+		owner = ids[B[b].owner];
+		name = ids[B[b].name];
+		putBranch(G->EXP, G->EDG, G->LG, owner, name, B[b].time);
+		List_incLenAct(G->LG, name, 1);
+		enterWindows(G, owner, name, 1, 0, B[b].time);
+	}
+	
+	G->entryCounter = info->entryCounter;
+	G->changed = 1;
+	
+	free(ids);
+	return 1;
+}
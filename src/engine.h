@@ -0,0 +1,162 @@
+#ifndef _engine_h
+#define _engine_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/types.h>
+#include "parser.h"
+#include "degrees.h"
+#include "snapshot.h"
+#include "venmoGraphParams.h"
+
+typedef struct enginePrototype engine;
+
+// The engine is the graph of the venmo events and everything that goes along
+// with it: the names of the nodes, their lists, the expiry and edge indices,
+// the histograms of the degrees and the max time. It takes the events one at
+// a time, or in batches, and gives the statistics of the graph after each.
+// An engine keeps no state outside of itself, so a program can run as many
+// engines as it likes, one per thread. venGraph (main.c) is a driver around
+// a single engine, or one per shard or chunk of the input.
+// Only the instrumentation (instrument.h) is shared by the whole process.
+
+// The windows of time over which the medians are taken, in seconds, in the
+// order of the columns of the output.
+typedef struct {
+	int count;
+	unsigned long int ages[MAX_WINDOWS];
+} windowSet;
+
+// A line of the output: the median of every window, and the other statistics
+// of the degrees chosen in venmoGraphParams. It holds copies of everything it
+// reports, names included, so it can be handed to another thread.
+typedef struct {
+	int numMedians;
+	float medians[MAX_WINDOWS];
+	int quantiles[NUM_QUANTILES + 1];
+	int numTop;
+	int topDegs[TOP_K + 1];
+	int topLens[TOP_K + 1];
+	char topNames[TOP_K + 1][MAX_STR_LEN];
+	unsigned long int memory;	// the bytes of the graph, with REPORT_MEMORY
+} statsLine;
+
+// The memory of the graph in bytes, structure by structure. What is counted
+// is what the structures are using: the arrays at their full size, and the
+// records of the pools that are handed out (the free records of a pool are
+// never more than those in use at the peak).
+typedef struct {
+	size_t names;	// the table of the names, and the arrays of their ids
+	size_t lists;	// the arrays of the lists by node id, the histograms and the ranking
+	size_t blocks;	// the blocks of the lists, one per branch with its expiry entry
+	size_t expiry;	// the buckets of the expiry index
+	size_t edges;	// the edge index
+	size_t total;
+	
+	// with a budget: the budget, the largest total before an event, the
+	// branches evicted early and the events kept out of the graph
+	size_t budget;
+	size_t peak;
+	unsigned long int evicted;
+	unsigned long int rejected;
+} engineMemory;
+
+// create an engine for the given windows
+// medianAlg is 1 for the naive median and 2 for the fast one (see the readme),
+// and the graph is printed after event printEntry has entered it (0 for never)
+engine* engine_create(windowSet* W, int medianAlg, int printEntry);
+
+// destroy the engine and its whole graph
+void engine_destroy(engine* E);
+
+// apply a valid event to the graph, and fill in the statistics of the graph
+// after it. the names of the event need only be valid during the call
+void engine_ingest(engine* E, venmoEvent* ev, statsLine* S);
+
+// ingest n events, one after the other, and fill in the statistics after
+// each of them in out[0..n-1], exactly as n calls of engine_ingest would
+// the batch is split into runs of events that can all meet the largest time
+// stamp of the run (see engine.c): the max time advances once per run and
+// the graph is pruned once, so the medians are only taken again after an
+// event of the run that changed a degree, not after every new max time
+void engine_ingestBatch(engine* E, venmoEvent* evs, int n, statsLine* out);
+
+// the two halves of ingest: apply an event, and take the statistics
+// (the graph of a shard or of a warm-up is never asked for statistics)
+void engine_apply(engine* E, venmoEvent* ev);
+void engine_stats(engine* E, statsLine* S);
+
+// The steps of engine_apply, for a caller that keeps the ids of the nodes of
+// its names (such as the replay of an event log):
+// advance the max time to the time stamp of an event, and return 0 if the
+// event is too old to go into the graph. this may remove nodes, so it comes
+// before their ids are looked up
+int engine_admit(engine* E, unsigned long int time);
+// the id of the node of a name, which is added to the graph if it is new
+uint32_t engine_node(engine* E, nameView* name);
+// the name of a node id, or NULL if the id is not a node
+char* engine_nodeName(engine* E, uint32_t id);
+// put the branch between the actor A and the target T into the graph, or give
+// it the time stamp if that is newer
+void engine_link(engine* E, uint32_t idA, uint32_t idT, unsigned long int time);
+
+// start an empty graph at the given max time, as if it had seen the events
+// before, and they had all expired
+void engine_startAt(engine* E, unsigned long int time);
+
+// advance the max time without an event
+void engine_advance(engine* E, unsigned long int time);
+
+// the max time, the longest window, the windows and the number of distinct
+// windows, and the median algorithm
+unsigned long int engine_maxTime(engine* E);
+unsigned long int engine_maxAge(engine* E);
+windowSet* engine_windows(engine* E);
+int engine_numWindows(engine* E);
+int engine_medianAlg(engine* E);
+
+// the seconds of processor time spent on the medians so far
+float engine_medianTime(engine* E);
+
+// Hold the memory of the graph to a budget of the given bytes (0 for none).
+// Before every event that goes into the graph, the oldest branches are
+// evicted, ahead of their time, until the total is below the budget. An
+// event older than the evicted branches is kept out of the graph, and so is
+// every event while the graph is empty and still over the budget (its
+// arrays never shrink). Either way the event is counted as rejected, and
+// still gets its statistics.
+// An event can take the graph over the budget by what it adds, and by a
+// table or an array that doubles as it grows, so leave room for that.
+void engine_setBudget(engine* E, size_t bytes);
+
+// the memory of the graph, and what the budget has cost
+void engine_memory(engine* E, engineMemory* M);
+
+// Sharding (see main.c). Make the engine the shard "shard" out of numShards:
+// a node that belongs to another shard is then only a ghost (see list.h).
+// Call this before the first event.
+void engine_setShard(engine* E, int shard, int numShards);
+
+// the shard of numShards that a name belongs to
+int engine_shardOf(char* name, int len, int numShards);
+
+// the histogram of the degrees of the graph
+degrees* engine_degrees(engine* E);
+
+// the median of a histogram of degrees, and its other statistics, without
+// the nodes of the highest degrees
+float engine_fastMedian(degrees* D);
+void engine_degreeStats(degrees* D, float median, statsLine* S);
+
+// Snapshots (see snapshot.h). Write a snapshot of the graph, which stands at
+// the given offset of the input after the given number of lines of the output.
+// engine_forkSnapshot returns the id of the child that writes it, or -1,
+// and engine_writeSnapshot 1 if it was written in this process, 0 otherwise.
+pid_t engine_forkSnapshot(engine* E, char* path, long long int offset, unsigned long int lines);
+int engine_writeSnapshot(engine* E, char* path, long long int offset, unsigned long int lines);
+
+// load the graph of a valid snapshot into an engine that has not seen any
+// event yet. 0 is returned if the snapshot was taken with other windows
+int engine_restore(engine* E, snapshot* S);
+
+#endif
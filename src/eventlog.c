@@ -0,0 +1,262 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include "eventlog.h"
+#include "table.h"
+#include "venmoGraphParams.h"
+
+// The layout of a log:
+//   | header | record | ... | record | offsets | names |
+// The dictionary is the array of numNames+1 offsets, followed by the names,
+// each terminated, one after the other. The name of id i starts at offset
+// offsets[i] of the names, and the next one at offsets[i+1].
+// The names only come up as the lines are converted, so the dictionary goes
+// at the end, and the header is written last.
+
+#define EVENTLOG_MAGIC "VENLOG1\n"
+
+typedef struct {
+	char magic[8];
+	uint64_t numRecords;
+	uint64_t numNames;
+	uint64_t dictOffset;	// where the offsets of the dictionary start
+	uint64_t size;			// of the whole log
+} logHeader;
+
+struct eventlogPrototype {
+	int fd;
+	char* data;
+	size_t size;
+
+	logRecord* records;
+	unsigned long int count;
+
+	uint32_t numNames;
+	uint64_t* offsets;
+	char* names;
+};
+
+eventlog* eventlog_open(char* path) {
+
+	struct stat st;
+	logHeader* H;
+	uint64_t i, namesOffset;
+
+	int fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return NULL;
+
+	if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || (size_t)st.st_size < sizeof(logHeader)) {
+		close(fd);
+		return NULL;
+	}
+
+	char* data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (data == MAP_FAILED) {
+		close(fd);
+		return NULL;
+	}
+
+	// Anything that does not add up is not a log. A file in the input
+	// format of the challenge starts with a brace, so it never gets past
+	// the magic.
+	H = (logHeader*)data;
+	namesOffset = H->dictOffset + (H->numNames + 1)*sizeof(uint64_t);
+	if (memcmp(H->magic, EVENTLOG_MAGIC, 8) != 0 || H->size != (uint64_t)st.st_size
+		|| H->numNames >= EVENTLOG_FAULTY
+		|| H->dictOffset != sizeof(logHeader) + H->numRecords*sizeof(logRecord)
+		|| namesOffset > H->size) {
+		munmap(data, st.st_size);
+		close(fd);
+		return NULL;
+	}
+
+	eventlog* L = malloc(sizeof(eventlog));
+	assert(L != NULL);
+
+	L->fd = fd;
+	L->data = data;
+	L->size = st.st_size;
+	L->records = (logRecord*)(data + sizeof(logHeader));
+	L->count = H->numRecords;
+	L->numNames = H->numNames;
+	L->offsets = (uint64_t*)(data + H->dictOffset);
+	L->names = data + namesOffset;
+
+	// every name must lie inside the log and be terminated
+	for (i=0; i<H->numNames; i++) {
+		if (L->offsets[i] >= L->offsets[i+1] || L->offsets[i+1] > H->size - namesOffset
+			|| L->names[L->offsets[i+1] - 1] != '\0') {
+			eventlog_close(L);
+			return NULL;
+		}
+	}
+
+	// the records are read from front to back
+	posix_madvise(L->records, L->count*sizeof(logRecord), POSIX_MADV_SEQUENTIAL);
+
+	return L;
+}
+
+void eventlog_close(eventlog* L) {
+	munmap(L->data, L->size);
+	close(L->fd);
+	free(L);
+}
+
+logRecord* eventlog_records(eventlog* L) {
+	return L->records;
+}
+
+unsigned long int eventlog_count(eventlog* L) {
+	return L->count;
+}
+
+uint32_t eventlog_numNames(eventlog* L) {
+	return L->numNames;
+}
+
+void eventlog_name(eventlog* L, uint32_t id, nameView* name) {
+	name->str = L->names + L->offsets[id];
+	name->len = (int)(L->offsets[id+1] - L->offsets[id] - 1);
+}
+
+// The writer gives every new name the next id, in a table from the names to
+// their ids, and collects the names of the dictionary in memory.
+
+struct eventlogWriterPrototype {
+	FILE* fp;
+	uint64_t numRecords;
+
+	table* ids;
+
+	uint64_t* offsets;	// numNames+1 of them
+	uint32_t numNames;
+	uint32_t capacity;	// of the offsets
+
+	char* names;
+	uint64_t namesSize;
+	uint64_t namesCapacity;
+};
+
+eventlogWriter* eventlog_create(char* path) {
+
+	logHeader H;
+
+	FILE* fp = fopen(path, "wb");
+	if (fp == NULL)
+		return NULL;
+	setvbuf(fp, NULL, _IOFBF, 1 << 20);
+
+	eventlogWriter* W = malloc(sizeof(eventlogWriter));
+	assert(W != NULL);
+
+	W->fp = fp;
+	W->numRecords = 0;
+	W->ids = table_create(sizeof(uint32_t), INITIAL_TABLE_SIZE, NULL);
+
+	W->capacity = INITIAL_TABLE_SIZE;
+	W->offsets = malloc((W->capacity + 1)*sizeof(uint64_t));
+	W->numNames = 0;
+	W->offsets[0] = 0;
+
+	W->namesCapacity = 1 << 16;
+	W->names = malloc(W->namesCapacity);
+	W->namesSize = 0;
+	assert(W->offsets != NULL && W->names != NULL);
+
+	// a blank header keeps the place of the real one
+	memset(&H, 0, sizeof(logHeader));
+	fwrite(&H, sizeof(logHeader), 1, fp);
+
+	return W;
+}
+
+// the id of a name, which is added to the dictionary if it is new
+static uint32_t nameId(eventlogWriter* W, nameView* name) {
+
+	void* cell = table_getCell(W->ids, name->str, name->len);
+	uint32_t id;
+
+	if (cell != NULL)
+		return *(uint32_t*)table_getDatum(cell);
+
+	id = W->numNames;
+	table_put(W->ids, name->str, name->len, &id);
+
+	// grow the arrays by doubling
+	if (id == W->capacity) {
+		W->capacity = W->capacity*2;
+		W->offsets = realloc(W->offsets, (W->capacity + 1)*sizeof(uint64_t));
+	}
+	while (W->namesSize + name->len + 1 > W->namesCapacity) {
+		W->namesCapacity = W->namesCapacity*2;
+		W->names = realloc(W->names, W->namesCapacity);
+	}
+	if (W->offsets == NULL || W->names == NULL) {
+		printf("\n\nFATAL ERROR: cannot expand the dictionary of the event log\n\n");
+		abort();
+	}
+
+	memcpy(W->names + W->namesSize, name->str, name->len);
+	W->names[W->namesSize + name->len] = '\0';
+	W->namesSize = W->namesSize + name->len + 1;
+	W->numNames++;
+	W->offsets[W->numNames] = W->namesSize;
+
+	return id;
+}
+
+void eventlog_append(eventlogWriter* W, venmoEvent* ev) {
+
+	logRecord rec;
+
+	memset(&rec, 0, sizeof(logRecord));
+	if (ev == NULL) {
+		rec.actor = EVENTLOG_FAULTY;
+		rec.target = EVENTLOG_FAULTY;
+	}
+	else {
+		rec.time = ev->time;
+		rec.actor = nameId(W, &ev->actor);
+		rec.target = nameId(W, &ev->target);
+	}
+
+	fwrite(&rec, sizeof(logRecord), 1, W->fp);
+	W->numRecords++;
+}
+
+int eventlog_finish(eventlogWriter* W) {
+
+	logHeader H;
+	int ok;
+
+	memcpy(H.magic, EVENTLOG_MAGIC, 8);
+	H.numRecords = W->numRecords;
+	H.numNames = W->numNames;
+	H.dictOffset = sizeof(logHeader) + W->numRecords*sizeof(logRecord);
+	H.size = H.dictOffset + (W->numNames + 1)*sizeof(uint64_t) + W->namesSize;
+
+	fwrite(W->offsets, sizeof(uint64_t), W->numNames + 1, W->fp);
+	fwrite(W->names, 1, W->namesSize, W->fp);
+
+	// the header goes in last, so a log that was cut short is never
+	// mistaken for a whole one
+	ok = (!ferror(W->fp) && fseek(W->fp, 0, SEEK_SET) == 0 && fwrite(&H, sizeof(logHeader), 1, W->fp) == 1);
+	ok = (fclose(W->fp) == 0) && ok;
+
+	table_destroy(W->ids);
+	free(W->offsets);
+	free(W->names);
+	free(W);
+
+	return ok;
+}
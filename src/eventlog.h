@@ -0,0 +1,56 @@
+#ifndef _eventlog_h
+#define _eventlog_h
+
+#include <stdint.h>
+#include "parser.h"
+
+// An event log is an input file that has already been parsed, so that it can
+// be replayed many times without parsing a single line again.
+// It starts with a header, followed by one fixed-width record per line of the
+// input, and ends with a dictionary of the names. The names in a record are
+// the ids of the names in the dictionary, so no name is stored twice.
+// The numbers are stored in the byte order of the machine that wrote the
+// log, so a log is only replayed on the kind of machine that wrote it.
+
+// the name id of the records of faulty lines
+#define EVENTLOG_FAULTY 0xFFFFFFFFu
+
+// A line of the input. The actor and the target are EVENTLOG_FAULTY if the
+// line is faulty, which is the validity flag of the record.
+typedef struct {
+	uint64_t time;		// seconds since the epoch (UTC)
+	uint32_t actor;
+	uint32_t target;
+} logRecord;
+
+typedef struct eventlogPrototype eventlog;
+typedef struct eventlogWriterPrototype eventlogWriter;
+
+// open the event log at path, which is memory-mapped in one piece
+// NULL is returned if the file cannot be opened, or is not an event log, so
+// a file of the input format of the challenge is told apart from a log
+eventlog* eventlog_open(char* path);
+
+// unmap and close the log
+void eventlog_close(eventlog* L);
+
+// the records of all the lines, in the order of the input, and their number
+logRecord* eventlog_records(eventlog* L);
+unsigned long int eventlog_count(eventlog* L);
+
+// the number of names in the dictionary, and the name of an id
+// the name stays valid, and put, until the log is closed
+uint32_t eventlog_numNames(eventlog* L);
+void eventlog_name(eventlog* L, uint32_t id, nameView* name);
+
+// create a new event log at path, or NULL if it cannot be created
+eventlogWriter* eventlog_create(char* path);
+
+// add the record of a line, or of a faulty line if ev is NULL
+void eventlog_append(eventlogWriter* W, venmoEvent* ev);
+
+// write the dictionary and the header, and close the log
+// 0 is returned if the log could not be written
+int eventlog_finish(eventlogWriter* W);
+
+#endif
@@ -0,0 +1,184 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include "expiry.h"
+
+// An entry of the index. It lives in memory provided by the caller.
+typedef struct expiryEntry {
+
+	unsigned long int time;
+
+	uint32_t owner;
+
+	struct expiryEntry* next;
+	struct expiryEntry* prev;
+} entry_t;
+
+struct expiryPrototype {
+
+	entry_t** buckets;
+
+	int span;
+
+	// every second older than the cursor has already been evicted
+	unsigned long int cursor;
+};
+
+expiry* expiry_create(int span) {
+
+	assert(span > 0);
+
+	expiry* E = malloc(sizeof(expiry));
+	assert(E != NULL);
+
+	E->span = span;
+	E->cursor = 0;
+
+	E->buckets = calloc(span, sizeof(entry_t*));
+	assert(E->buckets != NULL);
+
+	return E;
+}
+
+void expiry_start(expiry* E, unsigned long int cursor) {
+	E->cursor = cursor;
+}
+
+unsigned long int expiry_cursor(expiry* E) {
+	return E->cursor;
+}
+
+void expiry_destroy(expiry* E) {
+	free(E->buckets);
+	free(E);
+}
+
+size_t expiry_bytes(expiry* E) {
+	return sizeof(expiry) + (size_t)E->span*sizeof(entry_t*);
+}
+
+// link an entry into the bucket of its time stamp
+static void linkEntry(expiry* E, entry_t* e) {
+
+	// The ring has one bucket per second of the window.
+	// Every time stamp still in the index lies within span seconds of the
+	// cursor, so two different seconds never share a bucket.
+
+	entry_t** bucket = &E->buckets[e->time % E->span];
+
+	e->prev = NULL;
+	e->next = *bucket;
+	if (*bucket != NULL)
+		(*bucket)->prev = e;
+	*bucket = e;
+}
+
+int expiry_entrySize() {
+	return sizeof(entry_t);
+}
+
+void expiry_add(expiry* E, void* entry, unsigned long int time, uint32_t owner) {
+
+	entry_t* e = (entry_t*)entry;
+
+	e->time = time;
+	e->owner = owner;
+
+	linkEntry(E, e);
+}
+
+unsigned long int expiry_getTime(void* entry) {
+	return ((entry_t*)entry)->time;
+}
+
+uint32_t expiry_getOwner(void* entry) {
+	return ((entry_t*)entry)->owner;
+}
+
+// unlink an entry from its bucket
+static void unlinkEntry(expiry* E, entry_t* e) {
+
+	if (e->prev != NULL)
+		e->prev->next = e->next;
+	else
+		E->buckets[e->time % E->span] = e->next;
+
+	if (e->next != NULL)
+		e->next->prev = e->prev;
+}
+
+void expiry_touch(expiry* E, void* entry, unsigned long int time) {
+	unlinkEntry(E, (entry_t*)entry);
+	((entry_t*)entry)->time = time;
+	linkEntry(E, (entry_t*)entry);
+}
+
+void expiry_remove(expiry* E, void* entry) {
+	unlinkEntry(E, (entry_t*)entry);
+}
+
+void* expiry_pop(expiry* E, unsigned long int oldest) {
+
+	// Walk the cursor forward one second at a time until it reaches the
+	// oldest time stamp that is still allowed. Every bucket passed on the way
+	// is emptied, one entry per call.
+	// If the window moved by more than the span, every bucket has expired,
+	// so it is enough to visit each of them once.
+
+	entry_t* e;
+
+	if (E->cursor + E->span < oldest)
+		E->cursor = oldest - E->span;
+
+	while (E->cursor < oldest) {
+		e = E->buckets[E->cursor % E->span];
+		if (e != NULL) {
+			unlinkEntry(E, e);
+			return e;
+		}
+		E->cursor = E->cursor + 1;
+	}
+	return NULL;
+}
+
+void expiry_pass(expiry* E, unsigned long int* cursor, unsigned long int oldest, expiryPassFn fn, void* ctx) {
+
+	// The same walk as the pop, except that nothing is unlinked. Since
+	// the cursor of a shorter window may lag behind the span, the time
+	// stamp of every entry is checked, rather than that of its bucket.
+
+	entry_t* e;
+	unsigned long int sec = *cursor;
+	
+	if (oldest <= sec)
+		return;
+	if (sec + E->span < oldest)
+		sec = oldest - E->span;
+	
+	for (; sec < oldest; sec++) {
+		for (e = E->buckets[sec % E->span]; e != NULL; e = e->next) {
+			if (e->time >= *cursor && e->time < oldest)
+				fn(ctx, e);
+		}
+	}
+	*cursor = oldest;
+}
+
+int expiry_within(expiry* E, unsigned long int from, unsigned long int to) {
+
+	// The walk of a pass, without a cursor to move.
+
+	entry_t* e;
+	unsigned long int sec = from;
+	
+	if (sec + E->span < to)
+		sec = to - E->span;
+	
+	for (; sec < to; sec++) {
+		for (e = E->buckets[sec % E->span]; e != NULL; e = e->next) {
+			if (e->time >= from && e->time < to)
+				return 1;
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,65 @@
+#ifndef _expiry_h
+#define _expiry_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef struct expiryPrototype expiry;
+
+// create the expiry index by specifying its span, the number of one second
+// buckets in the ring. the span must cover the whole window, so we use one
+// more than the longest window (see main.c)
+expiry* expiry_create(int span);
+
+// start an empty index at the given cursor: every second older than it is
+// taken to have expired already. The index starts at 0 otherwise. An index
+// that starts late must start here, since it may only skip over the buckets
+// in which nothing can be left.
+void expiry_start(expiry* E, unsigned long int cursor);
+
+// every time stamp older than the cursor has left the index
+unsigned long int expiry_cursor(expiry* E);
+
+// destroy the index. the entries belong to the caller and are not freed
+void expiry_destroy(expiry* E);
+
+// the bytes the index holds, i.e. its buckets (the entries are the caller's)
+size_t expiry_bytes(expiry* E);
+
+// the index does not allocate its entries. an entry is a piece of memory of
+// expiry_entrySize() bytes provided by the caller, in our case the datum of a
+// list block, so that a branch carries its time stamp by value.
+int expiry_entrySize();
+
+// fill in an entry for a branch with the given time stamp and link it into the index
+// the owner is the id of the node whose list records the branch
+void expiry_add(expiry* E, void* entry, unsigned long int time, uint32_t owner);
+
+// recover the time stamp and the owner id of an entry
+unsigned long int expiry_getTime(void* entry);
+uint32_t expiry_getOwner(void* entry);
+
+// move an entry to a newer time stamp (its branch was refreshed)
+void expiry_touch(expiry* E, void* entry, unsigned long int time);
+
+// take an entry out of the index before it expires
+void expiry_remove(expiry* E, void* entry);
+
+// take one entry whose time stamp is older than "oldest" out of the index
+// NULL is returned when no such entry is left
+void* expiry_pop(expiry* E, unsigned long int oldest);
+
+// A shorter window follows the index with a cursor of its own, which the
+// caller keeps. Every entry whose time stamp is at least *cursor but older
+// than "oldest" is handed to fn, and the cursor moves to oldest.
+// The entries stay in the index; fn must not add, touch or remove any.
+// Pass the shorter windows before the index itself is popped for the same
+// max time, while every entry is still within the span.
+typedef void (*expiryPassFn)(void* ctx, void* entry);
+void expiry_pass(expiry* E, unsigned long int* cursor, unsigned long int oldest, expiryPassFn fn, void* ctx);
+
+// 1 if some entry has a time stamp of at least "from" but older than "to",
+// 0 otherwise. Like a pass, this looks at the entries but moves nothing.
+int expiry_within(expiry* E, unsigned long int from, unsigned long int to);
+
+#endif
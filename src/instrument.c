@@ -0,0 +1,180 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+#include "instrument.h"
+
+#if INSTRUMENT
+
+// The histograms have log-linear buckets, as in an HDR histogram: exact
+// below 2^SUB_BITS nanoseconds, and HALF_COUNT buckets per power of two
+// above, so every time is within about 6% of its bucket. That covers
+// everything from a nanosecond to minutes in a thousand buckets.
+#define SUB_BITS 5
+#define SUB_COUNT (1 << SUB_BITS)
+#define HALF_COUNT (SUB_COUNT / 2)
+#define NUM_BUCKETS (SUB_COUNT + (64 - SUB_BITS)*HALF_COUNT)
+
+typedef struct {
+	uint64_t buckets[NUM_BUCKETS];
+	uint64_t count;
+	uint64_t total;
+	uint64_t max;
+} histogram;
+
+static const char* stageNames[NUM_STAGES] = {
+	"parse", "lookup", "insert", "expire", "rehash", "median", "output"
+};
+
+static const char* counterNames[NUM_COUNTERS] = {
+	"lines", "faulty", "too_old", "new_branches", "refreshed", "expired",
+	"nodes_added", "nodes_removed", "rehashes", "evicted", "rejected", "output"
+};
+
+// The instrumentation belongs to the whole process, like a profiler, so
+// that any module can add to it without being handed anything. All the
+// updates are relaxed atomic additions: they only need to add up, and the
+// threads that share a stage rarely touch it at the same moment.
+static histogram stages[NUM_STAGES];
+static uint64_t counters[NUM_COUNTERS];
+
+static pthread_mutex_t dumpLock = PTHREAD_MUTEX_INITIALIZER;
+static int dumped = 0;			// the file is started over by the first snapshot
+static uint64_t startTime = 0;	// set before any other thread starts
+
+uint64_t instr_now() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec*1000000000 + ts.tv_nsec;
+}
+
+static int bucketOf(uint64_t v) {
+
+	int shift;
+
+	if (v < SUB_COUNT)
+		return (int)v;
+	shift = 63 - __builtin_clzll(v) - (SUB_BITS - 1);
+	return SUB_COUNT + (shift - 1)*HALF_COUNT + (int)((v >> shift) - HALF_COUNT);
+}
+
+// the smallest time that falls into bucket b
+static uint64_t bucketValue(int b) {
+
+	int shift;
+
+	if (b < SUB_COUNT)
+		return b;
+	shift = (b - SUB_COUNT)/HALF_COUNT + 1;
+	return (uint64_t)(HALF_COUNT + (b - SUB_COUNT) % HALF_COUNT) << shift;
+}
+
+void instr_time(instrStage stage, uint64_t nanos) {
+
+	histogram* H = &stages[stage];
+	uint64_t max = __atomic_load_n(&H->max, __ATOMIC_RELAXED);
+
+	__atomic_fetch_add(&H->buckets[bucketOf(nanos)], 1, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&H->count, 1, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&H->total, nanos, __ATOMIC_RELAXED);
+
+	while (nanos > max && !__atomic_compare_exchange_n(&H->max, &max, nanos, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+		;
+}
+
+void instr_count(instrCounter counter, uint64_t n) {
+	__atomic_fetch_add(&counters[counter], n, __ATOMIC_RELAXED);
+}
+
+// the time that a fraction p of the measurements do not exceed, from a
+// copy of the buckets
+static uint64_t percentile(uint64_t* buckets, uint64_t count, uint64_t max, double p) {
+
+	uint64_t rank = (uint64_t)(p * count);
+	uint64_t seen = 0;
+	int b;
+
+	for (b=0; b<NUM_BUCKETS; b++) {
+		seen = seen + buckets[b];
+		if (seen > rank)
+			return bucketValue(b);
+	}
+	return max;
+}
+
+// append a snapshot of everything to the stats file
+static void dump(int final) {
+
+	static uint64_t buckets[NUM_BUCKETS];
+	FILE* fp;
+	uint64_t count, total, max;
+	int i, b;
+	const char* sep;
+
+	fp = fopen(STATS_PATH, dumped ? "a" : "w");
+	if (fp == NULL)
+		return;
+	dumped = 1;
+
+	fprintf(fp, "{\"final\": %d, \"seconds\": %.6f, \"counters\": {", final, (instr_now() - startTime)*1e-9);
+	for (i=0; i<NUM_COUNTERS; i++)
+		fprintf(fp, "%s\"%s\": %lu", i ? ", " : "", counterNames[i],
+			(unsigned long int)__atomic_load_n(&counters[i], __ATOMIC_RELAXED));
+	fprintf(fp, "}, \"stages\": {");
+
+	for (i=0; i<NUM_STAGES; i++) {
+		for (b=0; b<NUM_BUCKETS; b++)
+			buckets[b] = __atomic_load_n(&stages[i].buckets[b], __ATOMIC_RELAXED);
+		count = __atomic_load_n(&stages[i].count, __ATOMIC_RELAXED);
+		total = __atomic_load_n(&stages[i].total, __ATOMIC_RELAXED);
+		max = __atomic_load_n(&stages[i].max, __ATOMIC_RELAXED);
+
+		fprintf(fp, "%s\"%s\": {\"count\": %lu, \"total_ns\": %lu, \"mean_ns\": %.1f", i ? ", " : "",
+			stageNames[i], (unsigned long int)count, (unsigned long int)total, count ? (double)total/count : 0.0);
+		fprintf(fp, ", \"p50_ns\": %lu, \"p90_ns\": %lu, \"p99_ns\": %lu, \"p999_ns\": %lu, \"max_ns\": %lu",
+			(unsigned long int)percentile(buckets, count, max, 0.50),
+			(unsigned long int)percentile(buckets, count, max, 0.90),
+			(unsigned long int)percentile(buckets, count, max, 0.99),
+			(unsigned long int)percentile(buckets, count, max, 0.999),
+			(unsigned long int)max);
+
+		// the histogram itself, as [lowest time of the bucket, count] for
+		// every bucket that is not empty
+		fprintf(fp, ", \"histogram\": [");
+		sep = "";
+		for (b=0; b<NUM_BUCKETS; b++) {
+			if (buckets[b] == 0)
+				continue;
+			fprintf(fp, "%s[%lu, %lu]", sep, (unsigned long int)bucketValue(b), (unsigned long int)buckets[b]);
+			sep = ", ";
+		}
+		fprintf(fp, "]}");
+	}
+	fprintf(fp, "}}\n");
+	fclose(fp);
+}
+
+void instr_output() {
+
+	uint64_t n = __atomic_add_fetch(&counters[COUNT_OUTPUT], 1, __ATOMIC_RELAXED);
+
+	// A thread that finds another one taking a snapshot does not wait for it.
+	if (STATS_INTERVAL > 0 && n % STATS_INTERVAL == 0 && pthread_mutex_trylock(&dumpLock) == 0) {
+		dump(0);
+		pthread_mutex_unlock(&dumpLock);
+	}
+}
+
+void instr_begin() {
+	startTime = instr_now();
+}
+
+void instr_finish() {
+	pthread_mutex_lock(&dumpLock);
+	dump(1);
+	pthread_mutex_unlock(&dumpLock);
+}
+
+#endif
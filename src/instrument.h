@@ -0,0 +1,78 @@
+#ifndef _instrument_h
+#define _instrument_h
+
+#include <stdint.h>
+#include "venmoGraphParams.h"
+
+// Instrumentation of the stages every event goes through, switched on at
+// compile time with INSTRUMENT in venmoGraphParams.
+// Every stage has a histogram of how long it took, in nanoseconds of the
+// monotonic clock, and the counters count what happened to the events.
+// A snapshot of both goes to the file STATS_PATH every STATS_INTERVAL lines
+// of the output, and once more at the end, as one JSON object per line.
+// With INSTRUMENT 0 all the macros below are empty, so nothing is measured
+// and nothing costs a thing.
+// The stages and counters are shared by all the threads, so the parser
+// threads, the graph thread and the writer thread all add to the same ones.
+
+typedef enum {
+	STAGE_PARSE,	// parsing a line
+	STAGE_LOOKUP,	// looking up (or adding) the actor and the target
+	STAGE_INSERT,	// putting the branch into the lists, or refreshing it
+	STAGE_EXPIRE,	// pruning the branches that fell out of the window(s)
+	STAGE_REHASH,	// starting a resize of a table
+	STAGE_MEDIAN,	// collecting the median and the other statistics
+	STAGE_OUTPUT,	// formatting a line of the output
+	NUM_STAGES
+} instrStage;
+
+typedef enum {
+	COUNT_LINES,		// lines parsed
+	COUNT_FAULTY,		// faulty lines among them
+	COUNT_TOO_OLD,		// events too old for the graph
+	COUNT_NEW_BRANCHES,	// branches put into the graph
+	COUNT_REFRESHED,	// branches moved to a newer time stamp
+	COUNT_EXPIRED,		// branches pruned
+	COUNT_NODES_ADDED,
+	COUNT_NODES_REMOVED,
+	COUNT_REHASHES,		// resizes of the tables
+	COUNT_EVICTED,		// branches evicted early to keep the memory budget
+	COUNT_REJECTED,		// events kept out of the graph by the budget
+	COUNT_OUTPUT,		// lines of the output
+	NUM_COUNTERS
+} instrCounter;
+
+#if INSTRUMENT
+
+uint64_t instr_now();
+void instr_time(instrStage stage, uint64_t nanos);
+void instr_count(instrCounter counter, uint64_t n);
+
+// start the clock of the snapshots, before any thread is started
+void instr_begin();
+
+// count a line of the output, and take a snapshot every STATS_INTERVAL lines
+void instr_output();
+
+// take the last snapshot
+void instr_finish();
+
+#define INSTR_START(t) uint64_t t = instr_now()
+#define INSTR_STOP(stage, t) instr_time(stage, instr_now() - (t))
+#define INSTR_COUNT(counter, n) instr_count(counter, n)
+#define INSTR_OUTPUT() instr_output()
+#define INSTR_BEGIN() instr_begin()
+#define INSTR_FINISH() instr_finish()
+
+#else
+
+#define INSTR_START(t)
+#define INSTR_STOP(stage, t)
+#define INSTR_COUNT(counter, n)
+#define INSTR_OUTPUT()
+#define INSTR_BEGIN()
+#define INSTR_FINISH()
+
+#endif
+
+#endif
@@ -0,0 +1,118 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "intern.h"
+#include "table.h"
+
+// Names are interned in a table whose datum is the id of the name.
+// The way back, from an id to its name, is an array of the cells of the
+// names in the table, which remain constant even after rehashing.
+// Released ids are kept on a stack and handed out before new ones, so
+// the ids stay dense and can index arrays directly.
+
+struct internPrototype {
+
+	table* T;
+
+	void** cells;		// cells[id] is the cell of id in T, or NULL
+	uint32_t capacity;	// size of the names array
+	uint32_t next;		// smallest id never handed out
+
+	uint32_t* freeIds;	// stack of released ids
+	uint32_t count_free;
+};
+
+intern* intern_create(int initCapacity) {
+
+	intern* I = malloc(sizeof(intern));
+	assert(I != NULL);
+
+	I->T = table_create(sizeof(uint32_t), initCapacity, NULL);
+
+	I->capacity = initCapacity;
+	I->next = 0;
+	I->count_free = 0;
+
+	I->cells = calloc(I->capacity, sizeof(void*));
+	I->freeIds = malloc(I->capacity*sizeof(uint32_t));
+	assert(I->cells != NULL && I->freeIds != NULL);
+
+	return I;
+}
+
+void intern_destroy(intern* I) {
+	table_destroy(I->T);
+	free(I->cells);
+	free(I->freeIds);
+	free(I);
+}
+
+int intern_count(intern* I) {
+	return table_count(I->T);
+}
+
+uint32_t intern_capacity(intern* I) {
+	return I->next;
+}
+
+size_t intern_bytes(intern* I) {
+	return sizeof(intern) + table_bytes(I->T) + (size_t)I->capacity*(sizeof(void*) + sizeof(uint32_t));
+}
+
+uint32_t intern_get(intern* I, char* name, int len) {
+
+	void* cell = table_getCell(I->T, name, len);
+
+	if (cell == NULL)
+		return INTERN_NONE;
+
+	return *(uint32_t*)table_getDatum(cell);
+}
+
+uint32_t intern_put(intern* I, char* name, int len) {
+
+	uint32_t id;
+
+	if (I->count_free > 0) {
+		I->count_free = I->count_free - 1;
+		id = I->freeIds[I->count_free];
+	}
+	else {
+		id = I->next;
+		I->next = I->next + 1;
+
+		// grow the arrays by doubling, as for the frequency array
+		if (id >= I->capacity) {
+			I->capacity = I->capacity*2;
+			I->cells = realloc(I->cells, I->capacity*sizeof(void*));
+			I->freeIds = realloc(I->freeIds, I->capacity*sizeof(uint32_t));
+
+			if (I->cells == NULL || I->freeIds == NULL) {
+				printf("\n\nFATAL ERROR: cannot expand the array of node names\n\n");
+				abort();
+			}
+		}
+	}
+
+	// the table rehashes by itself when it gets too full
+	I->cells[id] = table_put(I->T, name, len, &id);
+
+	return id;
+}
+
+char* intern_getName(intern* I, uint32_t id) {
+	if (id >= I->next || I->cells[id] == NULL)
+		return NULL;
+	return table_getKey(I->T, I->cells[id]);
+}
+
+void intern_remove(intern* I, uint32_t id) {
+
+	// the table shrinks by itself when it has drained
+	table_remove(I->T, I->cells[id]);
+	I->cells[id] = NULL;
+
+	I->freeIds[I->count_free] = id;
+	I->count_free = I->count_free + 1;
+}
@@ -0,0 +1,46 @@
+#ifndef _intern_h
+#define _intern_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef struct internPrototype intern;
+
+// id returned when a name has not been interned
+#define INTERN_NONE 0xFFFFFFFFu
+
+// create the interning layer by specifying the initial capacity of its table
+// (set in venmoGraphParams)
+intern* intern_create(int initCapacity);
+
+// destroy the interning layer and all the names in it
+void intern_destroy(intern* I);
+
+// recover the number of names (nodes) currently interned
+int intern_count(intern* I);
+
+// recover one more than the largest id handed out so far.
+// every live id is smaller than this
+uint32_t intern_capacity(intern* I);
+
+// the bytes the interning layer holds: its table, with the names in it,
+// and the arrays of the ids
+size_t intern_bytes(intern* I);
+
+// a name is given by its first character and its length, as it is read
+// straight out of the input line and is not terminated
+
+// get the id of a name, or INTERN_NONE if the name is not interned
+uint32_t intern_get(intern* I, char* name, int len);
+
+// intern a name that is not interned yet and return its new id
+// ids are dense: the ids of removed names are handed out again first
+uint32_t intern_put(intern* I, char* name, int len);
+
+// get the name of an id, or NULL if the id is not in use
+char* intern_getName(intern* I, uint32_t id);
+
+// remove the name with the given id and release the id
+void intern_remove(intern* I, uint32_t id);
+
+#endif
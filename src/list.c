@@ -1,256 +1,378 @@
-#include <stdio.h>
-#include <string.h>
-#include <stdlib.h>
-#include <assert.h>
-#include <signal.h>
-#include "list.h"
-#include "venmoGraphParams.h"
-
-struct ListPrototype {
-	
-	void* header;
-	
-	int length_rec;
-	int length_act;
-	
-	int dataSize;
-	int keySize;
-	
-	cleanListFn dataDeleter;
-};
-
-List* List_create(int keySize, int dataSize, cleanListFn fn) {
-
-	assert(dataSize > 0);
-	assert(keySize > 0);
-	
-	List* L = malloc(sizeof(List));
-	assert(L != NULL);
-	
-	L->length_rec = 0;
-	L->length_act = 0;
-	
-	L->keySize = keySize;
-	L->dataSize = dataSize;
-	
-	L->header = calloc(1,sizeof(void*));
-	assert(L->header != NULL);
-
-	L->dataDeleter = fn;
-	
-	return L;
-}
-
-void* List_getBlock(List* L, char* person) {
-
-	// begin by setting block to the list header, then loop over the recorded
-	// length of the list and proceed to the next block by dereferencing the 
-	// current block
-	
-	// a list block has the following structure:
-	//    | blkAddr | nameAddr | timestamp |
-	// "block" is the address of blkAddr
-	// to get to the nameAddr, we skip over the blkAddr 
-	// we dereference the nameAddr to get the name, and if it matches the 
-	// person, we return the block addr.
-
-	void* block = L->header;
-	
-	char** nameAddr;
-	char name[MAX_STR_LEN];
-	
-	for (int i = 0; i<List_lenRec(L); i++) {
-		name[0] = '\0';
-		nameAddr = (char**)((char*)block + sizeof(void*));
-		strcpy(name,*nameAddr);
-		
-        if ( strcmp(name, person) == 0 )
-            return block;
-        
-        block = *(void**)block;
-	}	
-	return NULL;
-}
-
-void* List_getName(void* block) {
-	return (char*)block + sizeof(void*);
-}
-
-void* List_getDatum(List* L, void* block) {
-	return (char*)block + sizeof(void*) + L->keySize;
-}
-
-void* List_firstBlock(List* L) {
-	return L->header;
-}
-
-void* List_nextBlock(void* block) {
-	return *(void**)block;
-}
-
-void List_put(List* L, void* keyAddr, void* datum) {
-
-	// remember the format of a list entry in memory:
-	//  | block | name | time |
-
-	// we want to add a new entry to list L
-	// the entry will have keyAddr in the name. 
-	// we call it keyAddr because it is the address of the key in of a different cell in the table that contains these lists
-	// the time will be the heap address of the timestamp
-
-	void* curBlock;
-	void* newBlock;
-	void* nxtBlock;
-	
-	unsigned long int timeStampNew = **(unsigned long int**)datum;
-	unsigned long int timeStampOld;
-	
-	List_incLenRec(L,1);
-	List_incLenAct(L,1);
-	
-	// the current block is the address of the header
-	// the new block will be our new entry
-	// the next block is the header.
-	
-	curBlock = &(L->header);
-	newBlock = malloc(sizeof(void**) + L->keySize + L->dataSize);
-	nxtBlock = L->header;
-	
-	// we begin with the header. if the list is empty, the header is empty, and we never enter the loop
-	// we want our list to be sorted chronologically so that all old entries can be deleted quickly
-	// to that end, we extract the time of the block. 
-	// if the time is older than our time, we will put our entry on top of this block
-	// otherwise we continue to the next block
-	
-	while (*(void**)nxtBlock != NULL) {
-		timeStampOld = **(unsigned long int**)List_getDatum(L, nxtBlock);
-		if (timeStampOld < timeStampNew)
-			break;
-		else {
-			curBlock = nxtBlock;
-			nxtBlock = *(void**)nxtBlock;
-		}
-	}
-	
-	// Ensure that the address in the new block references the location of the
-	// next block.
-	
-	*(void**)newBlock = nxtBlock;
-	*(void**)curBlock = newBlock;
-	
-	// Now that we have found a spot for our entry, 
-	// we compute the locations of the key and the datum, 
-	// and we copy the key and datum there
-	
-	void* keyDest = (char*)newBlock + sizeof(void*);
-	void* datDest = (char*)newBlock + sizeof(void*) + L->keySize;
-	
-	memcpy(keyDest, keyAddr, L->keySize);
-	memcpy(datDest, datum, L->dataSize);
-	
-}
-
-int* List_lenActFreq;
-int  List_lenActFreq_size = INIT_MAX_LEN;
-
-// Note that the global array cannot be initialized here. It must be initialized via a call from main
-
-void List_lenActFreq_initalize() {
-	List_lenActFreq = calloc(List_lenActFreq_size, sizeof(int)); // use calloc to ensure all entries are 0
-}
-
-void List_lenActFreq_destroy() {
-	free(List_lenActFreq);
-}
-
-void LIST_UPDATE_FREQS(int len, int inc) {												
-	
-	// here we update the array of degree frequencies. let's shorten the name of this array to DF for the comments
-	// in our computer representation of a graph, the list is a branch, and its length len is the degree
-	// index x of DF represents length len = x+1. DF[x] is the frequency of len
-	// we want to increase the frequency of len by inc
-	// this is easy unless len is greater than the array size
-	// in that case we must reallocate the array to a larger block of memory
-	// simply doing DF = realloc(DF) would not suffice, as it would not allow us to free(DF) when the program is complete
-	// instead we realloc to a temporary array, calloc DF to a new block, then memmove only the original elements
-	// memmove'ing all the elements would result in use moving garbage, as the temp was not calloc'd
-	
-	int* temp;
-	len--;																			
-	while (len > List_lenActFreq_size - 1) {										
-		temp = realloc(List_lenActFreq, 2*List_lenActFreq_size); 
-		List_lenActFreq = calloc(List_lenActFreq_size*2, sizeof(int));
-		
-		if (List_lenActFreq == NULL || temp == NULL) {
-			printf("\n\nFATAL ERROR: cannot expand array of vertex degree frequencies\n\n");
-			abort();
-		}
-		
-		memmove(List_lenActFreq, temp, List_lenActFreq_size*sizeof(int));
-		free(temp);
-			
-		List_lenActFreq_size = List_lenActFreq_size*2;	
-	}																				
-	List_lenActFreq[len] = List_lenActFreq[len] + inc;	
-}
-
-int List_lenAct(List* L) {
-	return L->length_act;
-}
-
-int List_lenRec(List* L) {
-	return L->length_rec;
-}
-
-void List_incLenAct(List* L, int inc) {
-	
-	// whenever the ACTUAL length is changed, the degree of the node changes
-	// if len increases by 1, we must first decrease the frequency of len, then increase the frequency of len+1
-	// but be careful when len becomes 0!
-	
-	int len = L->length_act;
-	
-	if (len != 0) LIST_UPDATE_FREQS(len, -1);
-
-	L->length_act = len + inc;
-	
-	len = L->length_act;
-	
-	if (len != 0) LIST_UPDATE_FREQS(len, 1);
-}
-
-void List_incLenRec(List* L, int inc) {
-	L->length_rec = L->length_rec + inc;
-}
-
-void* List_remove(List* L, void* block) {
-	
-	// unlike in the table, where new entries are simply placed on top of old ones, 
-	// entries in a list are organized chronologically
-	// we want to preserve this order and avoid the cost of traversing the whole list in search of our block
-	// so we just begin at our block, dereference it to get the next block, then copy the next block into our block
-	
-	List_incLenRec(L,-1);
-	List_incLenAct(L,-1);
-	
-	if (L->dataDeleter != NULL) {
-		L->dataDeleter(List_getDatum(L, block));
-	}
-	
-	void* nextBlock = *(void**)block;
-	
-	if (nextBlock != NULL) {
-		memcpy(block, nextBlock, sizeof(void*)+L->keySize+L->dataSize);
-		free(nextBlock);
-		return block;
-	}
-	else {
-		free(block);
-		return NULL;
-	}
-}
-
-void List_destroy(List* L) {
-	free(L->header);
-	free(L);
-}
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <signal.h>
+#include "list.h"
+#include "pool.h"
+#include "degrees.h"
+#include "ranking.h"
+#include "venmoGraphParams.h"
+
+// The lists of all the nodes, stored as arrays indexed by node id
+// rather than as one struct per node. Going through the lengths of
+// many nodes then walks contiguous memory.
+
+struct ListPrototype {
+	
+	void** header;
+	
+	int* length_rec;
+	int* length_act;
+	
+	unsigned char* ghost;	// 1 for the nodes left out of the histogram
+	
+	int capacity;	// number of node ids the arrays can hold
+	
+	int dataSize;
+	
+	pool* blocks;	// every block has the same size, so they come from one pool
+	
+	degrees* freqs;	// the histogram of the actual lengths (degrees)
+	
+	// the degrees in the shorter windows, and their histograms
+	// window w is kept at index w-1
+	int numWindows;
+	int** length_win;
+	degrees** winFreqs;
+	
+	ranking* order;	// the nodes grouped by degree, or NULL if not needed
+	
+	cleanListFn dataDeleter;
+};
+
+// a list block has the following structure:
+//    | blkAddr | prvAddr | name | datum |
+// "block" is the address of blkAddr
+// the name is the id of the node at the other end of the branch (uint32_t)
+// the datum starts at the next pointer boundary after the name
+
+#define BLOCK_NAME_OFFSET	(2*sizeof(void*))
+#define BLOCK_DATUM_OFFSET	(3*sizeof(void*))
+
+List* List_create(int dataSize, int initCapacity, cleanListFn fn) {
+
+	assert(dataSize > 0);
+	assert(initCapacity > 0);
+	
+	List* L = malloc(sizeof(List));
+	assert(L != NULL);
+	
+	L->capacity = initCapacity;
+	
+	L->header = calloc(initCapacity, sizeof(void*));
+	L->length_rec = calloc(initCapacity, sizeof(int));
+	L->length_act = calloc(initCapacity, sizeof(int));
+	L->ghost = calloc(initCapacity, 1);
+	assert(L->header != NULL && L->length_rec != NULL && L->length_act != NULL && L->ghost != NULL);
+	
+	L->dataSize = dataSize;
+	L->dataDeleter = fn;
+	
+	L->blocks = pool_create(BLOCK_DATUM_OFFSET + dataSize);
+	
+	L->freqs = degrees_create(INIT_MAX_LEN);
+	L->order = NULL;
+	
+	L->numWindows = 0;
+	L->length_win = NULL;
+	L->winFreqs = NULL;
+	
+	return L;
+}
+
+// make room for node "id" and give it an empty list
+static void addNode(List* L, uint32_t id, int ghost) {
+
+	// node ids are dense, so the arrays only need to grow when a new
+	// largest id is handed out. the capacity is doubled each time.
+	
+	int newCapacity = L->capacity;
+	int w;
+	
+	while ((int64_t)id >= (int64_t)newCapacity)
+		newCapacity = newCapacity*2;
+	
+	if (newCapacity != L->capacity) {
+		L->header = realloc(L->header, newCapacity*sizeof(void*));
+		L->length_rec = realloc(L->length_rec, newCapacity*sizeof(int));
+		L->length_act = realloc(L->length_act, newCapacity*sizeof(int));
+		L->ghost = realloc(L->ghost, newCapacity);
+		
+		if (L->header == NULL || L->length_rec == NULL || L->length_act == NULL || L->ghost == NULL) {
+			printf("\n\nFATAL ERROR: cannot expand the lists of the nodes\n\n");
+			abort();
+		}
+		
+		for (w=0; w<L->numWindows; w++) {
+			L->length_win[w] = realloc(L->length_win[w], newCapacity*sizeof(int));
+			if (L->length_win[w] == NULL) {
+				printf("\n\nFATAL ERROR: cannot expand the lists of the nodes\n\n");
+				abort();
+			}
+			memset(L->length_win[w] + L->capacity, 0, (newCapacity - L->capacity)*sizeof(int));
+		}
+		
+		// zero the new part of the arrays so that List_destroy can go through all of them
+		memset(L->header + L->capacity, 0, (newCapacity - L->capacity)*sizeof(void*));
+		memset(L->length_rec + L->capacity, 0, (newCapacity - L->capacity)*sizeof(int));
+		memset(L->length_act + L->capacity, 0, (newCapacity - L->capacity)*sizeof(int));
+		memset(L->ghost + L->capacity, 0, newCapacity - L->capacity);
+		
+		L->capacity = newCapacity;
+	}
+	
+	L->header[id] = NULL;
+	L->length_rec[id] = 0;
+	L->length_act[id] = 0;
+	L->ghost[id] = ghost;
+	
+	for (w=0; w<L->numWindows; w++)
+		L->length_win[w][id] = 0;
+}
+
+void List_addNode(List* L, uint32_t id) {
+	addNode(L, id, 0);
+}
+
+void List_addGhost(List* L, uint32_t id) {
+	addNode(L, id, 1);
+}
+
+uint32_t List_getName(void* block) {
+	return *(uint32_t*)((char*)block + BLOCK_NAME_OFFSET);
+}
+
+void* List_getDatum(void* block) {
+	return (char*)block + BLOCK_DATUM_OFFSET;
+}
+
+void* List_getBlockOfDatum(void* datum) {
+	return (char*)datum - BLOCK_DATUM_OFFSET;
+}
+
+void* List_firstBlock(List* L, uint32_t id) {
+	return L->header[id];
+}
+
+void* List_nextBlock(void* block) {
+	return *(void**)block;
+}
+
+void* List_put(List* L, uint32_t id, uint32_t name, void* datum) {
+
+	// we want to add a new entry to the list of node "id"
+	// the entry will have the id of the other node in the name
+	// the datum will be the expiry entry of the branch, which holds the timestamp
+	// the address of the new block is returned, and it stays constant until the block is removed
+	
+	// old entries are found through the expiry index, not by going down the list,
+	// so the list does not have to be sorted chronologically, and the new block
+	// simply goes on top of the list
+
+	void* newBlock = pool_alloc(L->blocks);
+	void* nxtBlock = L->header[id];
+	
+	List_incLenRec(L,id,1);
+	List_incLenAct(L,id,1);
+	
+	// Link the new block in front of the first block in both directions. 
+	
+	*(void**)newBlock = nxtBlock;
+	*((void**)newBlock + 1) = NULL;
+	
+	L->header[id] = newBlock;
+	
+	if (nxtBlock != NULL)
+		*((void**)nxtBlock + 1) = newBlock;
+	
+	// Copy the name and the datum into the block
+	
+	*(uint32_t*)((char*)newBlock + BLOCK_NAME_OFFSET) = name;
+	if (datum != NULL)
+		memcpy(List_getDatum(newBlock), datum, L->dataSize);
+	
+	return newBlock;
+}
+
+degrees* List_degrees(List* L) {
+	return L->freqs;
+}
+
+void List_enableRanking(List* L) {
+	if (L->order == NULL)
+		L->order = ranking_create(L->capacity);
+}
+
+ranking* List_ranking(List* L) {
+	return L->order;
+}
+
+size_t List_headerBytes(List* L) {
+
+	size_t bytes = sizeof(List) + degrees_bytes(L->freqs);
+	int w;
+	
+	// a pointer, two lengths and the ghost flag per id, and a length in
+	// every shorter window
+	bytes = bytes + (size_t)L->capacity*(sizeof(void*) + 2*sizeof(int) + 1 + L->numWindows*sizeof(int));
+	for (w=0; w<L->numWindows; w++)
+		bytes = bytes + sizeof(int*) + sizeof(degrees*) + degrees_bytes(L->winFreqs[w]);
+	if (L->order != NULL)
+		bytes = bytes + ranking_bytes(L->order);
+	return bytes;
+}
+
+size_t List_blockBytes(List* L) {
+	return pool_bytes(L->blocks);
+}
+
+int List_lenAct(List* L, uint32_t id) {
+	return L->length_act[id];
+}
+
+int List_lenRec(List* L, uint32_t id) {
+	return L->length_rec[id];
+}
+
+void List_incLenAct(List* L, uint32_t id, int inc) {
+	
+	// whenever the ACTUAL length is changed, the degree of the node changes
+	// if len increases by 1, we must first decrease the frequency of len, then increase the frequency of len+1
+	// but be careful when len becomes 0!
+	
+	int len = L->length_act[id];
+	
+	// the degree of a ghost is counted elsewhere
+	if (L->ghost[id]) {
+		L->length_act[id] = len + inc;
+		return;
+	}
+	
+	if (len != 0) degrees_add(L->freqs, len, -1);
+
+	L->length_act[id] = len + inc;
+	
+	len = L->length_act[id];
+	
+	if (len != 0) degrees_add(L->freqs, len, 1);
+	
+	if (L->order != NULL)
+		ranking_move(L->order, id, len - inc, len);
+}
+
+void List_addWindows(List* L, int n) {
+
+	int w;
+	
+	assert(L->numWindows == 0 && n >= 0);
+	if (n == 0)
+		return;
+	
+	L->numWindows = n;
+	L->length_win = malloc(n*sizeof(int*));
+	L->winFreqs = malloc(n*sizeof(degrees*));
+	assert(L->length_win != NULL && L->winFreqs != NULL);
+	
+	for (w=0; w<n; w++) {
+		L->length_win[w] = calloc(L->capacity, sizeof(int));
+		assert(L->length_win[w] != NULL);
+		L->winFreqs[w] = degrees_create(INIT_MAX_LEN);
+	}
+}
+
+int List_lenWindow(List* L, int w, uint32_t id) {
+	return (w == 0) ? L->length_act[id] : L->length_win[w-1][id];
+}
+
+degrees* List_windowDegrees(List* L, int w) {
+	return (w == 0) ? L->freqs : L->winFreqs[w-1];
+}
+
+void List_incWindow(List* L, int w, uint32_t id, int inc) {
+
+	if (w == 0) {
+		List_incLenAct(L, id, inc);
+		return;
+	}
+	
+	// the same bookkeeping as for the actual length, without the ranking
+	int* len = &L->length_win[w-1][id];
+	
+	if (!L->ghost[id] && *len != 0)
+		degrees_add(L->winFreqs[w-1], *len, -1);
+	
+	*len = *len + inc;
+	
+	if (!L->ghost[id] && *len != 0)
+		degrees_add(L->winFreqs[w-1], *len, 1);
+}
+
+void List_incLenRec(List* L, uint32_t id, int inc) {
+	L->length_rec[id] = L->length_rec[id] + inc;
+}
+
+void* List_remove(List* L, uint32_t id, void* block) {
+	
+	// the list is linked in both directions, so we can unlink our block
+	// without traversing the list in search of the previous block
+	// the addresses of all the other blocks remain constant, which allows 
+	// other structures (the expiry index) to hold on to them
+	// the address of the next block is returned (NULL at the end of the list)
+	
+	List_incLenRec(L,id,-1);
+	List_incLenAct(L,id,-1);
+	
+	if (L->dataDeleter != NULL) {
+		L->dataDeleter(List_getDatum(block));
+	}
+	
+	void* nextBlock = *(void**)block;
+	void* prevBlock = *((void**)block + 1);
+	
+	if (prevBlock == NULL)
+		L->header[id] = nextBlock;
+	else
+		*(void**)prevBlock = nextBlock;
+	
+	if (nextBlock != NULL)
+		*((void**)nextBlock + 1) = prevBlock;
+	
+	pool_free(L->blocks, block);
+	return nextBlock;
+}
+
+void List_destroy(List* L) {
+	
+	int i;
+	void* block;
+	void* nextBlock;
+	
+	// the blocks are released all at once with their pool, so the lists
+	// only have to be walked if the data need to be cleaned
+	if (L->dataDeleter != NULL) {
+		for (i=0; i<L->capacity; i++) {
+			block = L->header[i];
+			while (block != NULL) {
+				nextBlock = *(void**)block;
+				L->dataDeleter(List_getDatum(block));
+				block = nextBlock;
+			}
+		}
+	}
+	pool_destroy(L->blocks);
+	free(L->header);
+	free(L->length_rec);
+	free(L->length_act);
+	free(L->ghost);
+	for (i=0; i<L->numWindows; i++) {
+		free(L->length_win[i]);
+		degrees_destroy(L->winFreqs[i]);
+	}
+	free(L->length_win);
+	free(L->winFreqs);
+	degrees_destroy(L->freqs);
+	if (L->order != NULL)
+		ranking_destroy(L->order);
+	free(L);
+}
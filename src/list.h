@@ -1,51 +1,95 @@
-#ifndef _list_h
-#define _list_h
-
-typedef void (*cleanListFn) (void *addr);
-
-typedef struct ListPrototype List;
-
-// create the linked list by specifying the size of the key (char*), 
-// the size of the data (long int), and the cleaner function (something to free the data)
-List* List_create(int keySize, int dataSize, cleanListFn fn);
-
-// destroy the list
-void List_destroy(List* L);
-
-// initialize and free the global frequency array
-void List_lenActFreq_initalize();
-void List_lenActFreq_destroy();
-
-// update the frequency array
-// increase the frequency of list length "len" by "inc"
-void LIST_UPDATE_FREQS(int len, int inc);
-
-// recover the actual and recorded lengths of the list
-int List_lenAct(List* L);
-int List_lenRec(List* L);
-
-// increment the actual and recorded lengths
-void List_incLenAct(List* L, int inc);
-void List_incLenRec(List* L, int inc);
-
-// add an entry to the list
-// as a void*, the keyAddr can be a string (char*), or in our case, a pointer to one (char**)
-// add the datum by reference
-void List_put(List* L, void* keyAddr, void* datum);
-
-// get the address of a  block of memory from the list
-// then use that address to get the name and datum in the block
-void* List_getBlock(List* L, char* name);
-void* List_getName(void* block);
-void* List_getDatum(List* L, void* block);  
-
-// remove an entry from the list by specifying the memory address of its block 
-void* List_remove(List* L, void* block);
-
-// iterate through the entries in the list
-// begin by setting block = firstBlock. 
-// then in a loop update block = nextBlock.
-void* List_firstBlock(List* L);
-void* List_nextBlock(void* block);
-
-#endif
+#ifndef _list_h
+#define _list_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include "degrees.h"
+#include "ranking.h"
+
+typedef void (*cleanListFn) (void *addr);
+
+typedef struct ListPrototype List;
+
+// The List holds the linked lists of ALL the nodes of the graph.
+// A node is identified by its dense integer id (see intern.h), and its
+// actual length, recorded length and list header are kept in arrays
+// indexed by that id.
+
+// create the lists by specifying the size of the data (void*),
+// the initial number of nodes, and the cleaner function (something to free the data)
+List* List_create(int dataSize, int initCapacity, cleanListFn fn);
+
+// destroy the lists
+void List_destroy(List* L);
+
+// the bytes the lists hold: List_headerBytes for the arrays indexed by node
+// id, with the histograms and the ranking, and List_blockBytes for the
+// blocks, one per branch, with the data in them
+size_t List_headerBytes(List* L);
+size_t List_blockBytes(List* L);
+
+// make room for node "id" and give it an empty list
+void List_addNode(List* L, uint32_t id);
+
+// make room for node "id" as a ghost: a node whose degree is counted by
+// another graph (a shard of the sharded graph, see main.c). Its lengths are
+// kept as usual, but it is left out of the histogram and the ranking.
+void List_addGhost(List* L, uint32_t id);
+
+// the histogram of the actual lengths (degrees) of all the lists
+// it is kept up to date by List_incLenAct
+degrees* List_degrees(List* L);
+
+// group the nodes by degree as well, to find the nodes of the highest degrees
+// the ranking is kept up to date by List_incLenAct from then on, and it is
+// NULL until it is enabled, since most runs do not need it
+void List_enableRanking(List* L);
+ranking* List_ranking(List* L);
+
+// Keep the degrees of the nodes in n shorter windows of time as well, each
+// with a histogram of its own. The branches themselves are shared: a branch
+// that is in a shorter window is in the longest one too, so the degree of a
+// node in a shorter window is never more than its actual length.
+// The actual length is the degree in window 0, and the shorter windows are
+// numbered from 1. Call this before any node is added.
+void List_addWindows(List* L, int n);
+
+// recover and increment the degree of node "id" in window w,
+// and get the histogram of the degrees in window w
+int List_lenWindow(List* L, int w, uint32_t id);
+void List_incWindow(List* L, int w, uint32_t id, int inc);
+degrees* List_windowDegrees(List* L, int w);
+
+// recover the actual and recorded lengths of the list of node "id"
+int List_lenAct(List* L, uint32_t id);
+int List_lenRec(List* L, uint32_t id);
+
+// increment the actual and recorded lengths
+void List_incLenAct(List* L, uint32_t id, int inc);
+void List_incLenRec(List* L, uint32_t id, int inc);
+
+// add an entry on top of the list of node "id"
+// the name is the id of the node at the other end of the branch
+// add the datum by reference, or pass NULL to fill in the datum of the returned block later
+// the address of the new block is returned; it does not change until the block is removed
+void* List_put(List* L, uint32_t id, uint32_t name, void* datum);
+
+// use the address of a block of memory from the list
+// to get the name and datum in the block
+// the datum is stored in the block by value, so the block can also be
+// recovered from the address of its datum
+uint32_t List_getName(void* block);
+void* List_getDatum(void* block);
+void* List_getBlockOfDatum(void* datum);
+
+// remove an entry from the list of node "id" by specifying the memory address of its block
+// the address of the next block is returned
+void* List_remove(List* L, uint32_t id, void* block);
+
+// iterate through the entries in the list of node "id"
+// begin by setting block = firstBlock.
+// then in a loop update block = nextBlock.
+void* List_firstBlock(List* L, uint32_t id);
+void* List_nextBlock(void* block);
+
+#endif
@@ -1,573 +1,1493 @@
-#include <stdio.h>
-#include <string.h>
-#include <stdlib.h>
-#include <time.h>
-#include <math.h>
-#include "list.h"
-#include "table.h"
-#include "venmoGraphParams.h"
-
-// Global variable equal to the current maximum time stamp
-// (this may not be the time stamp of the current entry, as 
-//  entries need not arrive chronologically) 
-unsigned long int GLOBAL_MAX_TIME = 0;
-
-// Global array and its size, both defined in list.c
-// This is the array of frequencies of list lengths (aka node 
-// or vertex degrees) used for the fast median algorithm
-extern int* List_lenActFreq;
-extern int  List_lenActFreq_size;
-
-// Function pointer used by List_destroy to free time stamps
-static void dataCleaner(void* p) {
-	free(*(unsigned long int**)p);
-}
-
-// Function pointer used by table_destroy to free lists
-static void listCleaner(void* p) {
-	List_destroy(*(List**)p);
-}
-
-// update the graph by removing branches whose timestamps are
-// too old and nodes which have no branches
-void updateGraph(table* T) {
-
-	// Alg: go through all the cells in T
-	// Be careful when a cell is deleted; use a while loop!
-	
-	// Variable naming convention: 
-	// table memory is a "cell" identified by its "key"
-	// list memory is a "block" identified by its "name"
-	void* curCell = table_firstCell(T);
-	void* curBlock;
-	char* key;
-	char* name;
-	List* activeL;	// list in the table cell (node)
-	List* linkedL;  // list in the cell to which the above cell 
-	                // connects (i.e. node at the other end of
-					// the branch)
-	
-	int i,j,n;
-	
-	// Go through all the cells of the table, but DO NOT use a 
-	// for loop that ends with the table size. The size changes
-	// as cells are removed within the loop.
-	
-	while (curCell != NULL) {
-		key = (char*)table_getKey(curCell);
-		activeL = *(List**)table_getDatum(T, curCell, key);
-		
-		// If the current cell (node) has no branches, remove it
-		if (List_lenAct(activeL) == 0) {
-			table_remove(T, key);
-		}
-		else {
-			// go down the list. as soon as hit bad time, delete all after it
-			// we can do this because the list is arranged chronologically
-			curBlock = List_firstBlock(activeL);
-			n = List_lenRec(activeL);
-			for (i=0; i<n; i++) {
-				
-				// if the timestamp of the current block is too old, erase it and all that follow
-				if (GLOBAL_MAX_TIME - (**(unsigned long int**)List_getDatum(activeL, curBlock)) > MAX_AGE) {
-					for (j=i; j<n; j++) {
-						name = *(char**)List_getName(curBlock);
-						
-						// This is the crucial step and time optimization
-						// The name of the list is not actually a string but rather a pointer to a string
-						// It points to the address of the key of a completely different cell.
-						// We can access that cell's list by dereferencing the pointer, 
-						// then shifting over in memory by the length of the string + 1 
-						// (for the terminating null)
-						// the branch is removed from the graph when the actual length of the list is decremented
-						// and if the actual length falls to 0, we can immediately remove BOTH cells at the same time
-						
-						linkedL = *(List**)(name + strlen(name) + 1);
-						List_incLenAct(linkedL,-1);
-						if (List_lenAct(linkedL) == 0) {
-							table_remove(T,name);
-						}
-						curBlock = List_remove(activeL, curBlock);
-					}
-					break;
-				}
-				// otherwise go on to the next block
-				curBlock = List_nextBlock(curBlock);
-			}
-		}	
-		curCell = table_nextCell(T, curCell, key);
-		// If we deleted all the entries in the active list, check whether the actual length is 0, and if it is, then remove the whole cell
-		if (List_lenRec(activeL)==0 && List_lenAct(activeL)==0) {
-			table_remove(T, key);
-		}
-	}
-}
-
-// Input parser. The str is the input line. The actor and target
-// are extracted to the actor and target strings. The time T is 
-// malloc'd in the main function so that its address can be
-// stored in a list (it is subsequently freed in the List_remove
-// function). We pass the timestamp pointer to the parser by 
-// reference so that the parser can modify it, and therefore the
-// type is an  int**.
-// The parser is explained in detail in the readme, but in short,
-// if the input format is not matched exactly, the actor will be
-// empty, the target will be empty, or the time will be 0.
-void parseEntry(char* str, unsigned long int** T, char* actor, char* target) {
-
-	int year = -1, month = -1, day = -1, hour = -1, minute = -1, second = -1;
-	
-	sscanf(str, "{\"created_time\": \"%d-%d-%dT%d:%d:%dZ\", \"target\": \"%[^\"]\", \"actor\": \"%[^\"]", &year, &month, &day, &hour, &minute, &second, target, actor);
-	
-	if ( year == -1 || month == -1 || day == -1 || hour == -1 || minute == -1 || second == -1 )
-		**T = 0;
-	else {
-		struct tm timeDetails = { .tm_year = year - 1900,
-								  .tm_mon = month - 1,
-								  .tm_mday = day,
-								  .tm_hour = hour,
-								  .tm_min = minute,
-								  .tm_sec = second,
-								  .tm_isdst = -1
-		};
-		
-		time_t tT = mktime(&timeDetails);
-		**T = (unsigned long int) tT;
-	}
-}
-
-// integer sorter used by qsort for the naive median algorithm
-int intCmpFn (const void * a, const void * b) {
-   return ( *(int*)a - *(int*)b );
-}
-
-// the naive median, explained in the readme
-float naiveMedian(table* T) {
-
-	int n = table_count(T);
-
-	// array whose elements will be the list lengths (vertex degrees)
-	float* lenArr = malloc(n*sizeof(float));
-	float median;
-	
-	void* cell;
-	char* key;
-	cell = table_firstCell(T);
-	
-	// go through all the cells, get the actual length of each
-	int i;
-	for (i=0; i<n; i++) {
-		key = (char*)table_getKey(cell);
-		lenArr[i] = (float)List_lenAct(*(List**)table_getDatum(T, cell, key));
-		cell = table_nextCell(T,cell,key);
-	}
-	
-	// sort the array
-	qsort(lenArr, n, sizeof(int), intCmpFn);
-	
-	// get the middle number (median)
-	if (n % 2) {
-		median = ( lenArr[(n-1)/2] );
-	}
-	else {
-		int ind = n/2;
-		median = ( (lenArr[ind]+lenArr[ind-1])/2 );
-	}	
-	free(lenArr);
-	return median;
-}
-
-// fast median algorithm
-// tot is the total number of nodes in the graph
-float fastMedian(int tot) {
-
-	// The algorithm is explained in detail in the readme.
-	// At this point we have a global array List_lenActFreq.
-	// The indices of the array represent list lengths (degrees).
-	// The element at index x is the frequency of length x+1.
-	// Knowing the frequencies and the total (which could compute
-	// from the frequencies but already know in the main), we
-	// can easily compute the median.
-	
-	// 0 is returned if a median is not computed successfully. 
-
-	float halfTot = ((float)tot)/2;
-
-	int i,j;
-	
-	float sum = 0;
-	for (i=0; i<List_lenActFreq_size; i++) {
-		if (List_lenActFreq[i] != 0) {
-			
-			sum = sum + (float)List_lenActFreq[i];
-			
-			if ( fabs(sum - halfTot) < 0.00001 ) {
-				for (j = i+1; j<List_lenActFreq_size; j++) {
-					if (List_lenActFreq[j] > 0) {
-						break;
-					}
-				}
-				return (((float)(i+j+2))/2);
-			}
-			if (sum > halfTot) {
-				return ((float) (i+1));
-			}
-		}
-	}
-	return 0;
-}
-
-// Graph printer
-void printGraph(table* T) {
-
-	// Prints the entire graph. The format is explained in the
-	// readme. An example is also shown. 
-	// The printer is useful for debugging, and it can be called
-	// by the user with the fourth argument to the executable.
-
-	printf("\n\n*************************\n");
-	printf("******PRINTING GRAPH*****\n\n");
-	
-	printf("There are %d nodes in the graph\n",table_count(T));
-	
-	// table memory is a "cell" identified by its "key"
-	// list memory is a "block" identified by its "name"
-	
-	void* cell;
-	char* key;
-	void* block;
-	char name[MAX_STR_LEN];
-	unsigned long int timeStamp;
-	List* LST;
-	int i,j;
-	
-	cell = table_firstCell(T);
-	
-	// iterate through all the cells (nodes)
-	for (i=0; i<table_count(T); i++) {
-	
-		key = (char*)table_getKey(cell);
-		LST = *(List**)table_getDatum(T,cell,key);
-		
-		// Get a list and the name at the node
-		// Print the name and list lengths
-		printf("List %s:\tlenRec = %d,\tlenAct = %d\n",key,List_lenRec(LST),List_lenAct(LST));
-		
-		block = List_firstBlock(LST);
-		
-		// iterate through the list of the user and print the
-		// timestamp and name of everyone with whom that user 
-		// has traded and who is actually recorded in the list.
-		printf("\tList contents\n");
-		for(j=0; j<List_lenRec(LST); j++) {
-			
-			name[0] = '\0';
-			strcpy(name,*(char**)List_getName(block));
-			timeStamp = **(unsigned long int**)List_getDatum(LST, block);
-			printf("\t\tTarget %s @ %ld\n",name,timeStamp);
-			
-			block = List_nextBlock(block);
-		}
-	
-		printf("------------------------------\n");
-		cell = table_nextCell(T,cell,key);
-	}
-}
-
-int main(int argc, char* argv[]) {
-	
-	FILE* fp_out;
-	FILE* fp_in;
-	
-	int medianAlg = 2;	// Set to 1 to use the naiveMedian algorithm
-						// Can also be set by the user with the 3rd
-						// argument to the executable
-	
-	int entryCounter = 1;	// Increases after every line in the input file
-	int printEntry = 0;		// After which entry to print the graph
-	
-	clock_t timeBeg, timeEnd;	// variables for recording the time
-	float medianCompTime = 0;	// the computer takes to compute the
-								// median. useful for comparing the
-								// algorithms.
-								
-	// Parse the user inputs
-	// First is the input file
-	// Second is the output file
-	// Third is the median algorithm (1 slow, 2 fast)
-	// Fourth is the input file line after which to print the graph
-	// exit() rather than abort is used after bad inputs because at 
-	// this point the program hasn't done anything a core dump might
-	// illuminate
-	switch (argc) {
-		case 1:
-			fp_in = fopen("input.txt","r");
-			if (fp_in == NULL) { printf("\n\nERROR: default input file could not be opened\n\n"); exit(0); }
-			fp_out = fopen("output.txt","w");
-			if (fp_out == NULL) { printf("\n\nERROR: default output file could not be opened\n\n"); fclose(fp_in); exit(0); }
-			break;
-		case 2:
-			fp_in = fopen(argv[1],"r");
-			if (fp_in == NULL) { 
-				printf("\n\nERROR: user input file could not be opened\n\n"); 
-				exit(0); 
-			}
-			fp_out = fopen("output.txt","w");
-			if (fp_out == NULL) { 
-				printf("\n\nERROR: default output file could not be opened\n\n"); 
-				fclose(fp_in); 
-				exit(0);
-			}
-			break;
-		case 3:
-			fp_in = fopen(argv[1],"r");
-			if (fp_in == NULL) { 
-				printf("\n\nERROR: user input file could not be opened\n\n"); 
-				exit(0); 
-			}
-			fp_out = fopen(argv[2],"w");
-			if (fp_out == NULL) { 
-				printf("\n\nERROR: user output file could not be opened\n\n");  
-				fclose(fp_in); 
-				exit(0);
-			}
-			break;
-		case 4:
-			fp_in = fopen(argv[1],"r");
-			if (fp_in == NULL) { 
-				printf("\n\nERROR: user input file could not be opened\n\n"); 
-				exit(0); 
-			}
-			fp_out = fopen(argv[2],"w");
-			if (fp_out == NULL) { 
-				printf("\n\nERROR: user output file could not be opened\n\n"); 
-				fclose(fp_in);
-				exit(0); 
-			}
-			medianAlg = atoi(argv[3]);
-			if (medianAlg != 1 && medianAlg != 2) { 
-				printf("\n\nERROR: invalid median algorithm; set 1 or 2\n\n"); 
-				fclose(fp_in);
-				fclose(fp_out);
-				exit(0);
-			}
-			break;
-		case 5:
-			fp_in = fopen(argv[1],"r");
-			if (fp_in == NULL) { 
-				printf("\n\nERROR: user input file could not be opened\n\n"); 
-				exit(0); 
-			}
-			fp_out = fopen(argv[2],"w");
-			if (fp_out == NULL) { 
-				printf("\n\nERROR: user output file could not be opened\n\n"); 
-				fclose(fp_in);
-				exit(0); 
-			}
-			medianAlg = atoi(argv[3]);
-			if (medianAlg != 1 && medianAlg != 2) { 
-				printf("\n\nERROR: invalid median algorithm; set 1 or 2\n\n"); 
-				fclose(fp_in);
-				fclose(fp_out);
-				exit(0);
-			}
-			printEntry = atoi(argv[4]);
-			break;
-		default:
-			printf("\nERROR: faulty number of inputs\n\n");
-			exit(0);
-			break;
-	}
-	
-	void* cellA;	// actor cell
-	void* cellT;	// target cell
-	char* keyT;		// target key
-	char* keyA;		// actor key
-	
-	void* checkBlockA;
-	void* checkBlockT;
-	unsigned long int checkTime;
-	
-	// TABLE_LIST GRAPH (beecause the graph is a table of lists)
-	table* TLG = table_create(sizeof(List**), INITIAL_TABLE_SIZE, listCleaner);
-	
-	List* LA;	// actor list
-	List* LT;	// target list
-	
-	List_lenActFreq_initalize();	// initialize the global array
-									// used by the fast median
-	float median;
-	
-	char actor[MAX_STR_LEN];
-	char target[MAX_STR_LEN];
-	
-	unsigned long int* time;
-	char nameA[MAX_STR_LEN];	// actor name
-	char nameT[MAX_STR_LEN];	// target name
-	
-	char line[500];	// line of the input file
-	
-	// go through every line of the input file
-	while ( fgets(line,500,fp_in) != NULL ) {
-		
-		target[0] = '\0';
-		actor[0] = '\0';
-		time = malloc(sizeof(unsigned long int));
-		*time = 0;
-		
-		// store the timestamp in the heap, and its address in a list
-		// we might lose it if it were on the stack, and keeping 
-		// certain addresses constant is crucial 
-		
-		parseEntry(line, &time, actor, target);
-		
-		// skip the input line if it is faulty
-		if (actor[0]=='\0' || target[0]=='\0' || *time==0)
-			continue;
-		else
-		{
-			// If the timestamp is the most recent in calendar time,
-			// update the global max time
-			if (*time > GLOBAL_MAX_TIME) {
-				GLOBAL_MAX_TIME = *time;
-			}
-			
-			// If the timestamp is too old, we record the median, 
-			// but we don't bother updating the graph
-			if (GLOBAL_MAX_TIME - *time > MAX_AGE) {
-				if (medianAlg == 1) {
-					timeBeg = clock();
-					median =  naiveMedian(TLG);
-					timeEnd = clock();
-				}
-				if (medianAlg == 2)	{
-					timeBeg = clock();
-					median = fastMedian(table_count(TLG));
-					timeEnd = clock();
-				}
-				medianCompTime = medianCompTime + (float)(((float)timeEnd - (float)timeBeg)/CLOCKS_PER_SEC);
-				fprintf(fp_out, "%.2f\n", median);
-	
-				continue;
-			}
-			
-			// A = actor
-			// T = target
-			
-			strcpy(nameA,actor);
-			strcpy(nameT,target);
-			
-			cellA = table_getCell(TLG, nameA);
-			cellT = table_getCell(TLG, nameT);
-			
-			// IMPORTANT:
-			// In the following code, remember that LA and LT are 
-			// pointers to lists. That means we can extract them
-			// from the table, modify them here locally, and they are
-			// automatically updated in the table. So we do not have
-			// to "put" them back in the table when we're done with
-			// them. 
-			
-			// If A is not in the table, make an empty list for A,
-			// and put it in the table
-			// Otherwise, get the list from the table.
-			// Then do the same for T, but also get the key of T
-			if (cellA == NULL) {
-				LA = List_create(sizeof(char**), sizeof(long int*), dataCleaner);
-				keyA = table_put(TLG, nameA, &LA);
-			}
-			else {
-				LA = *(List**)table_getDatum(TLG, cellA, nameA);
-				keyA = table_getKey(cellA);
-			}
-			
-			if (cellT == NULL) {
-				LT = List_create(sizeof(char**), sizeof(long int*), dataCleaner);
-				keyT = table_put(TLG, nameT, &LT);
-			}
-			else {
-				LT = *(List**)table_getDatum(TLG, cellT, nameT);
-				keyT = table_getKey(cellT);
-			}
-			
-			// Now we want to check if T already exists in A's list, and if A exists in T's
-			// If one of the two cases holds, we get the timestamp of the trade
-			// Then if the current timestamp is more recent, we update the trade with the current timestamp.
-			// Before doing so, we remove the old trade (if possible), because the "List_put" function adds
-			// trades to a list chronologically.
-			
-			checkBlockA = List_getBlock(LA, keyT);
-			checkBlockT = List_getBlock(LT, keyA);
-			
-			// T is not in A, but A is in T, so we update T
-			if ( checkBlockA == NULL && checkBlockT != NULL) {
-				checkTime = **(unsigned long int**)List_getDatum(LT, checkBlockT);
-								
-				if (*time > checkTime) {
-					List_remove(LT, checkBlockT);
-					List_incLenAct(LA, -1);
-					
-					List_put(LT, &keyA, &time);
-					List_incLenAct(LA, 1);
-				}
-			}
-			
-			// T is in A, and A is not in T, so we update A
-			if ( checkBlockA != NULL && checkBlockT == NULL) {
-				checkTime = **(unsigned long int**)List_getDatum(LA, checkBlockA);
-								
-				if (*time > checkTime) {
-					List_remove(LA, checkBlockA);
-					List_incLenAct(LT, -1);
-					
-					List_put(LA, &keyT, &time);
-					List_incLenAct(LT, 1);
-				}
-			}
-			
-			// T is not in A, and A is not in T, so we put T in A
-			if ( checkBlockA == NULL && checkBlockT == NULL) {
-						
-				List_put(LA, &keyT, &time);
-				List_incLenAct(LT, 1);
-			} 
-			
-			// Check the load of the table, and rehash if necessary
-			table_checkLoad(TLG);
-			
-			// Update the table
-			updateGraph(TLG);
-			
-			if (medianAlg == 1) {
-				timeBeg = clock();
-				median =  naiveMedian(TLG);
-				timeEnd = clock();
-			}
-			if (medianAlg == 2)	{
-				timeBeg = clock();
-				median = fastMedian(table_count(TLG));
-				timeEnd = clock();
-			}
-			medianCompTime = medianCompTime + (float)(((float)timeEnd - (float)timeBeg)/CLOCKS_PER_SEC);
-			fprintf(fp_out, "%.2f\n", median);
-		}
-		
-		if (printEntry == entryCounter) {
-			printGraph(TLG);
-			printf("\n\n");
-		}
-			
-		entryCounter++;
-	}
-	
-	fclose(fp_in);
-	fclose(fp_out);
-
-	List_lenActFreq_destroy();
-	
-	table_destroy(TLG);
-	
-	printf("\nTotal median computation time:\t%.8f seconds\n\n",medianCompTime);
-	
-	return 0;
-}
\ No newline at end of file
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+#include <assert.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "engine.h"
+#include "degrees.h"
+#include "parser.h"
+#include "reader.h"
+#include "writer.h"
+#include "ring.h"
+#include "reorder.h"
+#include "eventlog.h"
+#include "snapshot.h"
+#include "instrument.h"
+#include "venmoGraphParams.h"
+
+// Batch of medians written to the output of a stream but not flushed yet
+typedef struct {
+	int pending;					// number of medians in the batch
+	unsigned long long int since;	// when the first of them was written
+} flushBatch;
+
+// monotonic clock in microseconds
+static unsigned long long int nowMicros() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned long long int)ts.tv_sec*1000000 + ts.tv_nsec/1000;
+}
+
+// seconds of processor time used by the calling thread
+// (the merger of the shards times its medians like the engine does)
+static double threadSeconds() {
+	struct timespec ts;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+	return ts.tv_sec + ts.tv_nsec*1e-9;
+}
+
+// hand the medians of the batch over to the reader of the output
+static void flushOutput(writer* fp_out, flushBatch* B) {
+	writer_flush(fp_out);
+	B->pending = 0;
+}
+
+// count a median just written to the output of a stream, and flush the
+// batch if it is full or if its first median has waited long enough
+static void batchMedian(writer* fp_out, flushBatch* B) {
+
+	unsigned long long int now = nowMicros();
+
+	if (B->pending == 0)
+		B->since = now;
+	B->pending++;
+	
+	if (B->pending >= STREAM_FLUSH_EVENTS || now - B->since >= STREAM_FLUSH_USEC)
+		flushOutput(fp_out, B);
+}
+
+// format a line of the output
+static void formatStats(writer* W, statsLine* S) {
+
+	if (NUM_QUANTILES == 0 && TOP_K == 0 && !REPORT_MEMORY && S->numMedians == 1) {
+		writer_putMedian(W, S->medians[0]);
+		return;
+	}
+	
+	int i;
+	
+	writer_putNumber(W, S->medians[0]);
+	
+	for (i=1; i<S->numMedians; i++) {
+		writer_putChar(W, ' ');
+		writer_putNumber(W, S->medians[i]);
+	}
+	
+	for (i=0; i<NUM_QUANTILES; i++) {
+		writer_putChar(W, ' ');
+		writer_putNumber(W, S->quantiles[i]);
+	}
+	
+	for (i=0; i<S->numTop; i++) {
+		writer_putChar(W, ' ');
+		writer_putText(W, S->topNames[i], S->topLens[i]);
+		writer_putChar(W, ':');
+		writer_putInt(W, S->topDegs[i]);
+	}
+	
+	if (REPORT_MEMORY) {
+		writer_putChar(W, ' ');
+		writer_putInt(W, S->memory);
+	}
+	
+	writer_putChar(W, '\n');
+}
+
+// write a line of the output
+static void writeStats(writer* W, statsLine* S) {
+	INSTR_START(t);
+	formatStats(W, S);
+	INSTR_STOP(STAGE_OUTPUT, t);
+	INSTR_OUTPUT();
+}
+
+// The snapshots.
+// With an interval > 0, a snapshot of the graph (see snapshot.h) is taken
+// every "interval" lines of the output, right after the line of an event, so the graph is that of the input up to the end of the event.
+// A child process writes it, while this one goes on. If the last snapshot is
+// still being written when the next one is due, the next one is skipped, so
+// the events never wait for the disk.
+// The offsets of the input are those of the file, or the number of records
+// of an event log. A stream has no offsets of its own, so the offsets of a
+// stream are counted on from the offset where the graph was resumed.
+// The interval is SNAPSHOT_INTERVAL, unless the environment variable
+// VENGRAPH_SNAPSHOT_INTERVAL gives another.
+
+typedef struct {
+	int on;
+	long int interval;			// lines of the output between two snapshots
+	pid_t child;				// the snapshot being written, or -1
+	long int countdown;			// lines of the output until the next one
+	unsigned long int lines;	// lines of the output so far
+	long long int offset;		// the input up to here has been applied
+	long long int base;			// added to the offsets of a resumed stream
+} snapshotState;
+
+// the interval of the snapshots, or -1 if the environment gives one that is
+// not a number of lines (0 turns the snapshots off)
+static long int snapshotInterval() {
+
+	char* value = getenv("VENGRAPH_SNAPSHOT_INTERVAL");
+	char* end;
+	long int interval;
+	
+	if (value == NULL)
+		return SNAPSHOT_INTERVAL;
+	interval = strtol(value, &end, 10);
+	if (end == value || *end != '\0' || interval < 0)
+		return -1;
+	return interval;
+}
+
+static void snapshotInit(snapshotState* SN, long int interval, int on) {
+	SN->on = on && interval > 0;
+	SN->interval = interval;
+	SN->child = -1;
+	SN->countdown = interval;
+	SN->lines = 0;
+	SN->offset = 0;
+	SN->base = 0;
+}
+
+// take a snapshot of the graph in a child process, or in this one if wait
+// is set, after waiting for the snapshot before it
+static void takeSnapshot(engine* G, snapshotState* SN, int wait) {
+
+	if (SN->child > 0) {
+		if (!snapshot_done(SN->child, wait))
+			return;
+		SN->child = -1;
+	}
+	
+	if (wait) {
+		if (!engine_writeSnapshot(G, SNAPSHOT_PATH, SN->offset, SN->lines))
+			printf("\n\nERROR: the snapshot %s could not be written\n\n", SNAPSHOT_PATH);
+	}
+	else {
+		SN->child = engine_forkSnapshot(G, SNAPSHOT_PATH, SN->offset, SN->lines);
+	}
+}
+
+// count a line of the output, after which the input goes on at "offset",
+// and take a snapshot if one is due
+static void snapshotLine(engine* G, snapshotState* SN, long long int offset) {
+
+	SN->lines++;
+	SN->offset = SN->base + offset;
+	
+	if (SN->on && --SN->countdown == 0) {
+		SN->countdown = SN->interval;
+		takeSnapshot(G, SN, 0);
+	}
+}
+
+// load the graph from the snapshot at SNAPSHOT_PATH, if there is one
+// the graph must be empty. the offset of the input where the snapshot left
+// off is returned, or -1 if there is no snapshot
+static long long int resumeGraph(engine* G, snapshotState* SN) {
+
+	snapshot* S = snapshot_open(SNAPSHOT_PATH);
+	
+	if (S == NULL)
+		return -1;
+	if (!snapshot_valid(S)) {
+		printf("\n\nERROR: %s is not a whole snapshot; delete it to start afresh\n\n", SNAPSHOT_PATH);
+		exit(0);
+	}
+	if (!engine_restore(G, S)) {
+		printf("\n\nERROR: the snapshot %s was taken with other windows\n\n", SNAPSHOT_PATH);
+		exit(0);
+	}
+	
+	SN->lines = snapshot_info(S)->lines;
+	SN->offset = snapshot_info(S)->inputOffset;
+	
+	snapshot_close(S);
+	return SN->offset;
+}
+
+// The reorder mode.
+// With REORDER_LATENESS > 0, the events go through a reorder buffer (see
+// reorder.h), so they are applied to the graph in the order of their time
+// stamps, except for the late ones, which are applied as soon as they arrive.
+// Every event still gets a line of the output, in the order of the input:
+// the line of an event is taken when the event is applied, and waits in a
+// window until the lines of all the events before it have gone out.
+
+// where the lines of the output go when they leave the window
+typedef void (*emitFn)(void* ctx, statsLine* S);
+
+typedef struct {
+	reorder* buffer;
+	
+	// the window of lines, indexed by the sequence number of their event
+	statsLine* lines;
+	char* ready;
+	unsigned long int capacity;	// a power of 2
+	
+	unsigned long int next;		// the sequence number of the next event
+	unsigned long int first;	// the sequence number of the next line to go out
+	
+	emitFn emit;
+	void* ctx;
+} reorderState;
+
+#define INIT_REORDER_WINDOW 64
+
+static void reorderInit(reorderState* X) {
+
+	X->buffer = reorder_create(REORDER_LATENESS);
+	X->capacity = INIT_REORDER_WINDOW;
+	X->lines = malloc(X->capacity*sizeof(statsLine));
+	X->ready = calloc(X->capacity, 1);
+	assert(X->lines != NULL && X->ready != NULL);
+	X->next = 0;
+	X->first = 0;
+	X->emit = NULL;
+	X->ctx = NULL;
+}
+
+static void reorderFree(reorderState* X) {
+	reorder_destroy(X->buffer);
+	free(X->lines);
+	free(X->ready);
+}
+
+// double the window, keeping every waiting line under its sequence number
+static void growWindow(reorderState* X) {
+
+	unsigned long int newCapacity = X->capacity*2;
+	statsLine* lines = malloc(newCapacity*sizeof(statsLine));
+	char* ready = calloc(newCapacity, 1);
+	unsigned long int seq;
+	
+	if (lines == NULL || ready == NULL) {
+		printf("\n\nFATAL ERROR: cannot expand the window of the reorder mode\n\n");
+		abort();
+	}
+	for (seq=X->first; seq<X->next; seq++) {
+		lines[seq & (newCapacity-1)] = X->lines[seq & (X->capacity-1)];
+		ready[seq & (newCapacity-1)] = X->ready[seq & (X->capacity-1)];
+	}
+	
+	free(X->lines);
+	free(X->ready);
+	X->lines = lines;
+	X->ready = ready;
+	X->capacity = newCapacity;
+}
+
+// apply an event and take its line
+static void applyInWindow(engine* G, reorderState* X, venmoEvent* ev, unsigned long int seq) {
+	engine_ingest(G, ev, &X->lines[seq & (X->capacity-1)]);
+	X->ready[seq & (X->capacity-1)] = 1;
+}
+
+// apply the events the watermark has passed, and send out the lines
+// that are no longer waiting for an earlier one
+static void drainWindow(engine* G, reorderState* X) {
+
+	venmoEvent ev;
+	unsigned long int seq;
+	
+	while (reorder_pop(X->buffer, &ev, &seq))
+		applyInWindow(G, X, &ev, seq);
+	
+	while (X->first < X->next && X->ready[X->first & (X->capacity-1)]) {
+		X->emit(X->ctx, &X->lines[X->first & (X->capacity-1)]);
+		X->ready[X->first & (X->capacity-1)] = 0;
+		X->first++;
+	}
+}
+
+// a valid event of the input in the reorder mode
+static void reorderEvent(engine* G, reorderState* X, venmoEvent* ev) {
+
+	unsigned long int seq = X->next;
+	
+	if (seq - X->first == X->capacity)
+		growWindow(X);
+	X->next++;
+	
+	if (!reorder_push(X->buffer, ev, seq))
+		applyInWindow(G, X, ev, seq);
+	
+	drainWindow(G, X);
+}
+
+// the end of the input in the reorder mode
+static void reorderEnd(engine* G, reorderState* X) {
+	reorder_flush(X->buffer);
+	drainWindow(G, X);
+}
+
+// The pipeline.
+// A regular input file is replayed by several threads at once:
+// the parser threads split the file into lines and parse them,
+// the graph thread (the main thread) applies the events to the graph in the
+// order of the input, and the writer thread formats and writes the output.
+// The threads hand their work over in rings (see ring.h), one ring for every
+// parser thread and one for the writer, so that no ring has more than one
+// thread on either side.
+
+// A line of the input, as it travels from a parser thread to the graph thread.
+// The names are copied, since the line may be gone by the time the graph
+// thread gets to them.
+typedef struct {
+	int valid;		// 0 if the line is faulty
+	long long int end;	// the offset in the file right after the line
+	unsigned long int time;
+	int actorLen;
+	int targetLen;
+	char actor[MAX_STR_LEN];
+	char target[MAX_STR_LEN];
+} eventRecord;
+
+// The work of a parser thread. With several parser threads, every thread reads
+// the whole input, but parses only every numWorkers-th line, starting with
+// line "worker". The graph thread takes the lines from the rings in turn, so
+// they are applied in order, and a faulty line is passed on as well, to keep
+// the turns in step.
+typedef struct {
+	reader* in;
+	ring* out;
+	int worker;
+	int numWorkers;
+} parserJob;
+
+static void* parserThread(void* arg) {
+
+	parserJob* J = (parserJob*)arg;
+	parser* PRS = parser_create();
+	venmoEvent ev;
+	eventRecord* rec;
+	
+	char* line;
+	int lineLen;
+	int turn = 0;
+	
+	while (reader_next(J->in, &line, &lineLen)) {
+	
+		if (turn != J->worker) {
+			turn = (turn + 1) % J->numWorkers;
+			continue;
+		}
+		turn = (turn + 1) % J->numWorkers;
+		
+		rec = (eventRecord*)ring_claim(J->out);
+		rec->valid = parser_parse(PRS, line, lineLen, &ev);
+		rec->end = reader_offset(J->in) + lineLen;
+		if (rec->valid) {
+			rec->time = ev.time;
+			rec->actorLen = ev.actor.len;
+			rec->targetLen = ev.target.len;
+			memcpy(rec->actor, ev.actor.str, ev.actor.len);
+			memcpy(rec->target, ev.target.str, ev.target.len);
+		}
+		ring_publish(J->out);
+	}
+	
+	ring_close(J->out);
+	parser_destroy(PRS);
+	return NULL;
+}
+
+// The work of the writer thread
+typedef struct {
+	ring* in;
+	writer* out;
+} writerJob;
+
+static void* writerThread(void* arg) {
+
+	writerJob* J = (writerJob*)arg;
+	statsLine* S;
+	
+	while ((S = (statsLine*)ring_peek(J->in)) != NULL) {
+		writeStats(J->out, S);
+		ring_release(J->in);
+	}
+	return NULL;
+}
+
+// The threads of the pipeline around the graph
+typedef struct {
+	int numWorkers;
+	parserJob* jobs;
+	pthread_t* parsers;
+	writerJob wjob;
+	pthread_t writerId;
+} pipeline;
+
+// start the parser threads on the input file at inPath, from the offset
+// "from" on, and the writer thread
+// fp_in is already open on the file from there, and becomes the reader of the first parser thread
+static void startPipeline(pipeline* P, char* inPath, long long int from, reader* fp_in, writer* fp_out) {
+
+	int w;
+	
+	P->numWorkers = PIPELINE_PARSERS;
+	P->jobs = malloc(P->numWorkers*sizeof(parserJob));
+	P->parsers = malloc(P->numWorkers*sizeof(pthread_t));
+	assert(P->jobs != NULL && P->parsers != NULL);
+	
+	for (w=0; w<P->numWorkers; w++) {
+		P->jobs[w].in = (w == 0 ? fp_in : reader_openRange(inPath, from, -1));
+		if (P->jobs[w].in == NULL) {
+			printf("\n\nFATAL ERROR: the input file could not be opened again for parser thread %d\n\n", w);
+			abort();
+		}
+		P->jobs[w].out = ring_create(sizeof(eventRecord), PIPELINE_RING_SIZE);
+		P->jobs[w].worker = w;
+		P->jobs[w].numWorkers = P->numWorkers;
+		if (pthread_create(&P->parsers[w], NULL, parserThread, &P->jobs[w]) != 0) {
+			printf("\n\nFATAL ERROR: parser thread %d could not be started\n\n", w);
+			abort();
+		}
+	}
+	
+	P->wjob.in = ring_create(sizeof(statsLine), PIPELINE_RING_SIZE);
+	P->wjob.out = fp_out;
+	if (pthread_create(&P->writerId, NULL, writerThread, &P->wjob) != 0) {
+		printf("\n\nFATAL ERROR: the writer thread could not be started\n\n");
+		abort();
+	}
+}
+
+// take the next line of the input from the parser threads, in turn, or NULL
+// at the end of the input. turn starts at 0. the names of the line stay put
+// until it is released with releaseLine.
+static eventRecord* nextLine(pipeline* P, int turn) {
+	return (eventRecord*)ring_peek(P->jobs[turn].out);
+}
+
+static int releaseLine(pipeline* P, int turn) {
+	ring_release(P->jobs[turn].out);
+	return (turn + 1) % P->numWorkers;
+}
+
+// Take the lines of the input that the parser threads already have ready,
+// starting with "first", the next line, which is the line of this turn.
+// Line j of the batch is in the ring of turn + j, behind the lines of the
+// batch before it in that ring. No line is waited for, and the batch stops
+// at INGEST_BATCH lines, or at maxValid valid ones. The lines stay put until
+// they are released, in turn.
+static int gatherLines(pipeline* P, int turn, eventRecord* first, eventRecord** recs, int maxValid) {
+
+	int numLines = 1;
+	int numValid = first->valid;
+	eventRecord* rec;
+	
+	recs[0] = first;
+	while (numLines < INGEST_BATCH && numValid < maxValid) {
+		rec = (eventRecord*)ring_peekAhead(P->jobs[(turn + numLines) % P->numWorkers].out, numLines / P->numWorkers);
+		if (rec == NULL)
+			break;
+		recs[numLines++] = rec;
+		numValid = numValid + rec->valid;
+	}
+	return numLines;
+}
+
+// wait for the parser threads and the writer thread to finish
+// every statsLine has been published to the writer ring by now
+static void stopPipeline(pipeline* P) {
+
+	int w;
+	
+	// Every parser thread has closed its ring by now, since they all read
+	// the same lines and the one whose turn came up had none left.
+	ring_close(P->wjob.in);
+	pthread_join(P->writerId, NULL);
+	ring_destroy(P->wjob.in);
+	
+	for (w=0; w<P->numWorkers; w++) {
+		pthread_join(P->parsers[w], NULL);
+		ring_destroy(P->jobs[w].out);
+		if (w > 0)
+			reader_close(P->jobs[w].in);
+	}
+	
+	free(P->jobs);
+	free(P->parsers);
+}
+
+// fill in an event with the names in a line from a parser thread
+static void eventOfLine(eventRecord* rec, venmoEvent* ev) {
+	ev->time = rec->time;
+	ev->actor.str = rec->actor;
+	ev->actor.len = rec->actorLen;
+	ev->target.str = rec->target;
+	ev->target.len = rec->targetLen;
+}
+
+// hand a line of the reorder window over to the writer thread
+static void emitToRing(void* ctx, statsLine* S) {
+	memcpy(ring_claim((ring*)ctx), S, sizeof(statsLine));
+	ring_publish((ring*)ctx);
+}
+
+// replay the input file at inPath through the pipeline
+// X is the state of the reorder mode, or NULL if it is off
+// from the offset "from" on, where fp_in is open
+static void runPipeline(engine* G, char* inPath, long long int from, reader* fp_in, writer* fp_out, reorderState* X, snapshotState* SN) {
+
+	pipeline P;
+	eventRecord* rec;
+	venmoEvent ev;
+	int turn = 0;
+	
+	// a batch of lines, the events of its valid lines, and their output
+	eventRecord* recs[INGEST_BATCH];
+	venmoEvent evs[INGEST_BATCH];
+	statsLine lines[INGEST_BATCH];
+	int numLines, n, k;
+	
+	startPipeline(&P, inPath, from, fp_in, fp_out);
+	
+	if (X != NULL) {
+		X->emit = emitToRing;
+		X->ctx = P.wjob.in;
+	}
+	
+	// The graph thread. The names of an event point into its record, which
+	// stays put until it is released, after the event has been applied
+	// (or copied into the reorder buffer).
+	while ((rec = nextLine(&P, turn)) != NULL) {
+		if (X != NULL) {
+			if (rec->valid) {
+				eventOfLine(rec, &ev);
+				reorderEvent(G, X, &ev);
+			}
+			turn = releaseLine(&P, turn);
+			continue;
+		}
+		
+		// A snapshot is due after the last event of a batch at the latest,
+		// so that it holds the graph of the input up to its offset.
+		numLines = gatherLines(&P, turn, rec, recs, (SN->on && SN->countdown < INGEST_BATCH) ? (int)SN->countdown : INGEST_BATCH);
+		n = 0;
+		for (k=0; k<numLines; k++) {
+			if (recs[k]->valid)
+				eventOfLine(recs[k], &evs[n++]);
+		}
+		engine_ingestBatch(G, evs, n, lines);
+		
+		n = 0;
+		for (k=0; k<numLines; k++) {
+			if (recs[k]->valid) {
+				memcpy(ring_claim(P.wjob.in), &lines[n++], sizeof(statsLine));
+				ring_publish(P.wjob.in);
+				snapshotLine(G, SN, recs[k]->end);
+			}
+			turn = releaseLine(&P, turn);
+		}
+	}
+	
+	if (X != NULL)
+		reorderEnd(G, X);
+	
+	stopPipeline(&P);
+}
+
+// The sharded graph.
+// With GRAPH_SHARDS > 1, the graph itself is split among several threads.
+// Every node belongs to one shard, picked by the hash of its name, and a
+// shard keeps every branch of its own nodes. So an event whose actor and
+// target belong to different shards is applied by both of them, and each of
+// them keeps the node of the other shard as a ghost, whose degree it does not
+// count (see list.h). Every shard then knows the exact degrees of its own
+// nodes, and keeps their histogram.
+// The main thread deals the events out to the shards. A merger thread replays
+// the changes of the shard histograms into one histogram, event by event in
+// the order of the input, and takes the statistics of every line from it.
+// A shard only learns the time from the events it gets, so when the max time
+// advances, every shard without the event gets a tick instead, and prunes
+// its branches at the same event as everyone else.
+
+// A message from the main thread to a shard
+typedef struct {
+	int tick;			// 1 if only the max time advanced, to rec.time
+	eventRecord rec;
+} shardMessage;
+
+// The changes that a message made to the histogram of a shard, as
+// (degree, inc) pairs (see degrees_journal). A long list of changes, after a
+// big expiry, is split over several records, and the last one is marked.
+#define SHARD_CHANGES 62
+
+typedef struct {
+	int last;
+	int count;
+	int degs[SHARD_CHANGES];
+	int incs[SHARD_CHANGES];
+} shardChanges;
+
+// What the merger collects for an event: nothing if the event was too old,
+// otherwise the changes of the shards of its actor and target, or those of
+// every shard if the max time advanced.
+typedef struct {
+	int tooOld;
+	int tick;
+	int shardA;
+	int shardT;
+} eventRoute;
+
+// The work of a shard thread
+typedef struct {
+	engine* G;
+	ring* in;	// messages from the main thread
+	ring* out;	// changes to the merger
+} shardJob;
+
+// pass the changes in the journal of the shard histogram on to the merger
+static void sendChanges(shardJob* J) {
+
+	degrees* D = engine_degrees(J->G);
+	shardChanges* C;
+	int* degs;
+	int* incs;
+	int n = degrees_journal(D, &degs, &incs);
+	int i = 0;
+	
+	// a message without changes still sends a record, so that the merger
+	// knows the shard is done with the event
+	do {
+		C = (shardChanges*)ring_claim(J->out);
+		C->count = (n - i < SHARD_CHANGES ? n - i : SHARD_CHANGES);
+		memcpy(C->degs, degs + i, C->count*sizeof(int));
+		memcpy(C->incs, incs + i, C->count*sizeof(int));
+		i = i + C->count;
+		C->last = (i == n);
+		ring_publish(J->out);
+	} while (i < n);
+	
+	degrees_clearJournal(D);
+}
+
+static void* shardThread(void* arg) {
+
+	shardJob* J = (shardJob*)arg;
+	shardMessage* M;
+	venmoEvent ev;
+	
+	while ((M = (shardMessage*)ring_peek(J->in)) != NULL) {
+		if (M->tick) {
+			engine_advance(J->G, M->rec.time);
+		}
+		else {
+			eventOfLine(&M->rec, &ev);
+			engine_apply(J->G, &ev);
+		}
+		ring_release(J->in);
+		sendChanges(J);
+	}
+	return NULL;
+}
+
+// The work of the merger thread
+typedef struct {
+	ring* routes;		// routes of the events, from the main thread
+	shardJob* shards;	// the changes of every shard come from its out ring
+	int numShards;
+	ring* out;			// lines of the output, to the writer thread
+	degrees* merged;	// the histogram of the degrees of all the nodes
+	float medianCompTime;
+} mergerJob;
+
+// replay the changes of a shard for one event into the merged histogram
+static void mergeChanges(mergerJob* J, ring* changes) {
+
+	shardChanges* C;
+	int i, last;
+	
+	do {
+		C = (shardChanges*)ring_peek(changes);
+		for (i=0; i<C->count; i++)
+			degrees_add(J->merged, C->degs[i], C->incs[i]);
+		last = C->last;
+		ring_release(changes);
+	} while (!last);
+}
+
+static void* mergerThread(void* arg) {
+
+	mergerJob* J = (mergerJob*)arg;
+	eventRoute* R;
+	double timeBeg, timeEnd;
+	float median;
+	int s;
+	
+	while ((R = (eventRoute*)ring_peek(J->routes)) != NULL) {
+	
+		if (!R->tooOld) {
+			for (s=0; s<J->numShards; s++) {
+				if (R->tick || s == R->shardA || s == R->shardT)
+					mergeChanges(J, J->shards[s].out);
+			}
+		}
+		ring_release(J->routes);
+		
+		INSTR_START(t);
+		timeBeg = threadSeconds();
+		median = engine_fastMedian(J->merged);
+		timeEnd = threadSeconds();
+		J->medianCompTime = J->medianCompTime + (float)(timeEnd - timeBeg);
+		
+		engine_degreeStats(J->merged, median, (statsLine*)ring_claim(J->out));
+		INSTR_STOP(STAGE_MEDIAN, t);
+		ring_publish(J->out);
+	}
+	return NULL;
+}
+
+// replay the input file at inPath through the pipeline, with the graph split
+// into GRAPH_SHARDS shards
+// G only keeps the max time, and the time spent on the medians is returned
+static float runSharded(engine* G, char* inPath, reader* fp_in, writer* fp_out) {
+
+	int numShards = GRAPH_SHARDS;
+	shardJob* shards = malloc(numShards*sizeof(shardJob));
+	pthread_t* shardIds = malloc(numShards*sizeof(pthread_t));
+	assert(shards != NULL && shardIds != NULL);
+	
+	pipeline P;
+	mergerJob mjob;
+	pthread_t mergerId;
+	int s;
+	
+	startPipeline(&P, inPath, 0, fp_in, fp_out);
+	
+	for (s=0; s<numShards; s++) {
+		shards[s].G = engine_create(engine_windows(G), engine_medianAlg(G), 0);
+		engine_setShard(shards[s].G, s, numShards);
+		degrees_startJournal(engine_degrees(shards[s].G));
+		
+		shards[s].in = ring_create(sizeof(shardMessage), PIPELINE_RING_SIZE);
+		shards[s].out = ring_create(sizeof(shardChanges), PIPELINE_RING_SIZE);
+		if (pthread_create(&shardIds[s], NULL, shardThread, &shards[s]) != 0) {
+			printf("\n\nFATAL ERROR: shard thread %d could not be started\n\n", s);
+			abort();
+		}
+	}
+	
+	mjob.routes = ring_create(sizeof(eventRoute), PIPELINE_RING_SIZE);
+	mjob.shards = shards;
+	mjob.numShards = numShards;
+	mjob.out = P.wjob.in;
+	mjob.merged = degrees_create(INIT_MAX_LEN);
+	mjob.medianCompTime = 0;
+	if (pthread_create(&mergerId, NULL, mergerThread, &mjob) != 0) {
+		printf("\n\nFATAL ERROR: the merger thread could not be started\n\n");
+		abort();
+	}
+	
+	// Deal the events out. The route of an event is published before the
+	// event goes to the shards, so the merger can always take the changes
+	// the shards have made, and no thread ends up waiting for another in a
+	// circle.
+	eventRecord* rec;
+	eventRoute* R;
+	shardMessage* M;
+	int turn = 0;
+	
+	while ((rec = nextLine(&P, turn)) != NULL) {
+	
+		if (!rec->valid) {
+			turn = releaseLine(&P, turn);
+			continue;
+		}
+		
+		R = (eventRoute*)ring_claim(mjob.routes);
+		R->tick = (rec->time > engine_maxTime(G));
+		engine_advance(G, rec->time);
+		R->tooOld = (engine_maxTime(G) - rec->time > engine_maxAge(G));
+		R->shardA = engine_shardOf(rec->actor, rec->actorLen, numShards);
+		R->shardT = engine_shardOf(rec->target, rec->targetLen, numShards);
+		ring_publish(mjob.routes);
+		
+		if (!R->tooOld) {
+			for (s=0; s<numShards; s++) {
+				if (s == R->shardA || s == R->shardT) {
+					M = (shardMessage*)ring_claim(shards[s].in);
+					M->tick = 0;
+					M->rec = *rec;
+					ring_publish(shards[s].in);
+				}
+				else if (R->tick) {
+					M = (shardMessage*)ring_claim(shards[s].in);
+					M->tick = 1;
+					M->rec.time = rec->time;
+					ring_publish(shards[s].in);
+				}
+			}
+		}
+		
+		turn = releaseLine(&P, turn);
+	}
+	
+	for (s=0; s<numShards; s++)
+		ring_close(shards[s].in);
+	ring_close(mjob.routes);
+	
+	pthread_join(mergerId, NULL);
+	stopPipeline(&P);
+	
+	for (s=0; s<numShards; s++) {
+		pthread_join(shardIds[s], NULL);
+		ring_destroy(shards[s].in);
+		ring_destroy(shards[s].out);
+		engine_destroy(shards[s].G);
+	}
+	ring_destroy(mjob.routes);
+	degrees_destroy(mjob.merged);
+	
+	free(shards);
+	free(shardIds);
+	
+	return mjob.medianCompTime;
+}
+
+// The backfill.
+// With BACKFILL_WORKERS > 1, a regular input file is cut into that many
+// chunks, which are processed at the same time by worker threads, each with
+// a graph of its own. The output of every chunk goes to a file of its own
+// (the first chunk's straight to the output), and these files are appended
+// to the output in order at the end.
+// A worker needs the graph as it is at the start of its chunk. Every branch
+// in it comes from an event at most maxAge seconds (the longest window) older
+// than the max time there, so the worker does not replay the whole file before
+// its chunk, only the part since the max time was last more than maxAge
+// seconds lower.
+// To find that part, the file is divided into blocks of BACKFILL_BLOCK bytes,
+// and in a first pass the workers find the max time of every block of their
+// chunks. The warm-up then starts at the last block before which the max
+// time was more than maxAge seconds below the max time at the start of the
+// chunk: whatever came before that block has expired by the start of the
+// chunk, no matter in which order the events came. The worker replays the
+// lines from that block on, starting with the max time before it, without
+// writing anything until its chunk begins. Every event then meets the same
+// max time as in a single pass, so it is either applied or found too old
+// just the same, and from the start of the chunk the graph is the same.
+
+#define BACKFILL_BLOCK (1 << 20)
+
+// The work of a backfill worker
+typedef struct {
+	char* inPath;
+	long long int from;				// the chunk is [from, to)
+	long long int to;				// -1 for the last chunk
+	unsigned long int* blockMax;	// the max time of every block of the file
+	long long int warmFrom;			// where the warm-up starts
+	unsigned long int warmTime;		// and the max time before it
+	char tmpPath[4096];				// the output of the chunk, unless it is the first
+	writer* out;
+	engine* G;
+} backfillJob;
+
+// the first pass: find the max time of every block of the chunk
+static void* scanChunk(void* arg) {
+
+	backfillJob* J = (backfillJob*)arg;
+	reader* in = reader_openRange(J->inPath, J->from, J->to);
+	parser* PRS;
+	venmoEvent ev;
+	char* line;
+	int lineLen;
+	long long int b;
+	
+	if (in == NULL) {
+		printf("\n\nFATAL ERROR: the input file could not be opened again for the backfill\n\n");
+		abort();
+	}
+	PRS = parser_create();
+	
+	while (reader_next(in, &line, &lineLen)) {
+		if (!parser_parse(PRS, line, lineLen, &ev))
+			continue;
+		b = reader_offset(in) / BACKFILL_BLOCK;
+		if (ev.time > J->blockMax[b])
+			J->blockMax[b] = ev.time;
+	}
+	
+	parser_destroy(PRS);
+	reader_close(in);
+	return NULL;
+}
+
+// the second pass: warm the graph up, then process the chunk
+static void* runChunk(void* arg) {
+
+	backfillJob* J = (backfillJob*)arg;
+	reader* in = reader_openRange(J->inPath, J->warmFrom, J->to);
+	parser* PRS;
+	venmoEvent ev;
+	statsLine stats;
+	char* line;
+	int lineLen;
+	
+	if (in == NULL) {
+		printf("\n\nFATAL ERROR: the input file could not be opened again for the backfill\n\n");
+		abort();
+	}
+	PRS = parser_create();
+	engine_startAt(J->G, J->warmTime);
+	
+	while (reader_next(in, &line, &lineLen)) {
+		if (!parser_parse(PRS, line, lineLen, &ev))
+			continue;
+		engine_apply(J->G, &ev);
+		if (reader_offset(in) >= J->from) {
+			engine_stats(J->G, &stats);
+			writeStats(J->out, &stats);
+		}
+	}
+	
+	parser_destroy(PRS);
+	reader_close(in);
+	return NULL;
+}
+
+// run the workers of the backfill through one pass
+static void runWorkers(backfillJob* jobs, int numWorkers, void* (*pass)(void*)) {
+
+	pthread_t* ids = malloc(numWorkers*sizeof(pthread_t));
+	assert(ids != NULL);
+	int c;
+	
+	for (c=0; c<numWorkers; c++) {
+		if (pthread_create(&ids[c], NULL, pass, &jobs[c]) != 0) {
+			printf("\n\nFATAL ERROR: backfill worker %d could not be started\n\n", c);
+			abort();
+		}
+	}
+	for (c=0; c<numWorkers; c++)
+		pthread_join(ids[c], NULL);
+	
+	free(ids);
+}
+
+// replay the input file at inPath in numWorkers chunks at once
+// the time the workers spent on the medians is returned
+static float runBackfill(engine* G, char* inPath, reader* fp_in, writer* fp_out, int numWorkers) {
+
+	long long int numBlocks = reader_size(fp_in) / BACKFILL_BLOCK + 1;
+	long long int first, b;
+	int c, fd;
+	char* line;
+	int lineLen;
+	reader* part;
+	float medianTime = 0;
+	
+	// the outputs of the chunks go to the temporary directory of the user
+	char* tmpDir = getenv("TMPDIR");
+	if (tmpDir == NULL || tmpDir[0] == '\0')
+		tmpDir = "/tmp";
+	
+	backfillJob* jobs = malloc(numWorkers*sizeof(backfillJob));
+	unsigned long int* blockMax = calloc(numBlocks, sizeof(unsigned long int));
+	unsigned long int* before = malloc((numBlocks + 1)*sizeof(unsigned long int));
+	assert(jobs != NULL && blockMax != NULL && before != NULL);
+	
+	// The chunks are whole blocks, so that the blocks of a chunk are only
+	// ever scanned by its own worker.
+	for (c=0; c<numWorkers; c++) {
+		jobs[c].inPath = inPath;
+		jobs[c].from = (numBlocks*c/numWorkers)*BACKFILL_BLOCK;
+		jobs[c].to = (c == numWorkers - 1) ? -1 : (numBlocks*(c+1)/numWorkers)*BACKFILL_BLOCK;
+		jobs[c].blockMax = blockMax;
+	}
+	
+	runWorkers(jobs, numWorkers, scanChunk);
+	
+	// before[b] is the max time of all the blocks before block b
+	before[0] = 0;
+	for (b=0; b<numBlocks; b++)
+		before[b+1] = (blockMax[b] > before[b]) ? blockMax[b] : before[b];
+	
+	for (c=0; c<numWorkers; c++) {
+	
+		first = jobs[c].from / BACKFILL_BLOCK;
+		b = first;
+		while (b > 0 && before[b] + engine_maxAge(G) >= before[first])
+			b--;
+		jobs[c].warmFrom = b*BACKFILL_BLOCK;
+		jobs[c].warmTime = before[b];
+		
+		jobs[c].G = engine_create(engine_windows(G), engine_medianAlg(G), 0);
+		
+		if (c == 0) {
+			jobs[c].out = fp_out;
+			continue;
+		}
+		fd = -1;
+		if (snprintf(jobs[c].tmpPath, sizeof(jobs[c].tmpPath), "%s/venGraph.XXXXXX", tmpDir) < (int)sizeof(jobs[c].tmpPath))
+			fd = mkstemp(jobs[c].tmpPath);
+		if (fd < 0 || (jobs[c].out = writer_open(jobs[c].tmpPath)) == NULL) {
+			printf("\n\nFATAL ERROR: cannot create a temporary output file for the backfill\n\n");
+			abort();
+		}
+		close(fd);
+	}
+	
+	runWorkers(jobs, numWorkers, runChunk);
+	
+	// append the outputs of the chunks in order
+	for (c=0; c<numWorkers; c++) {
+		medianTime = medianTime + engine_medianTime(jobs[c].G);
+		engine_destroy(jobs[c].G);
+		if (c == 0)
+			continue;
+		
+		writer_close(jobs[c].out);
+		part = reader_open(jobs[c].tmpPath);
+		if (part == NULL) {
+			printf("\n\nFATAL ERROR: cannot read a temporary output file of the backfill\n\n");
+			abort();
+		}
+		while (reader_next(part, &line, &lineLen))
+			writer_putText(fp_out, line, lineLen);
+		reader_close(part);
+		unlink(jobs[c].tmpPath);
+	}
+	
+	free(jobs);
+	free(blockMax);
+	free(before);
+	
+	return medianTime;
+}
+
+// The output of the main thread, when there is no pipeline
+typedef struct {
+	writer* W;
+	int streaming;
+	flushBatch batch;
+} directOutput;
+
+// parse the windows given as seconds separated by commas, e.g. "60,300,3600"
+// 0 is returned if the list is not valid
+static int parseWindows(char* list, windowSet* W) {
+
+	char* end;
+	long int age;
+	
+	W->count = 0;
+	for (;;) {
+		age = strtol(list, &end, 10);
+		if (end == list || age <= 0 || W->count == MAX_WINDOWS)
+			return 0;
+		W->ages[W->count] = age;
+		W->count++;
+		
+		if (*end == '\0')
+			return 1;
+		if (*end != ',')
+			return 0;
+		list = end + 1;
+	}
+}
+
+// write a line of the output from the main thread
+static void emitDirect(void* ctx, statsLine* S) {
+	directOutput* D = (directOutput*)ctx;
+	writeStats(D->W, S);
+	if (D->streaming)
+		batchMedian(D->W, &D->batch);
+}
+
+// The replay of an event log.
+// An event log (see eventlog.h) holds the lines of an input file already
+// parsed, with the names replaced by the ids of a dictionary. So a replay
+// neither parses a line nor hashes a name: the node of every name of the
+// dictionary is remembered, and nodeOfName checks that the node is still
+// the node of that name, which it is unless the node has been removed.
+// Only the names that are not nodes of the graph are looked up in the table.
+
+typedef struct {
+	eventlog* L;
+	uint32_t* node;		// node[n] is the node of name n, if it still is
+	uint32_t* name;		// name[id] is the name the node id was last given
+	uint32_t capacity;	// of the names
+} logNodes;
+
+static uint32_t nodeOfName(engine* G, logNodes* C, uint32_t n) {
+
+	uint32_t id = C->node[n];
+	nameView name;
+	
+	if (id < C->capacity && C->name[id] == n && engine_nodeName(G, id) != NULL)
+		return id;
+	
+	eventlog_name(C->L, n, &name);
+	id = engine_node(G, &name);
+	
+	// grow the names of the nodes by doubling
+	if (id >= C->capacity) {
+		while (id >= C->capacity)
+			C->capacity = C->capacity*2;
+		C->name = realloc(C->name, C->capacity*sizeof(uint32_t));
+		if (C->name == NULL) {
+			printf("\n\nFATAL ERROR: cannot expand the names of the nodes of the event log\n\n");
+			abort();
+		}
+	}
+	C->node[n] = id;
+	C->name[id] = n;
+	return id;
+}
+
+// replay the event log in this thread, from record "from" on
+// X is the state of the reorder mode, or NULL if it is off
+static void runLog(engine* G, eventlog* L, long long int from, directOutput* out, reorderState* X, snapshotState* SN) {
+
+	logRecord* records = eventlog_records(L);
+	logRecord* rec;
+	unsigned long int count = eventlog_count(L);
+	uint32_t numNames = eventlog_numNames(L);
+	unsigned long int i;
+	uint32_t idA, idT;
+	statsLine stats;
+	venmoEvent ev;
+	logNodes C;
+	
+	C.L = L;
+	C.node = malloc((numNames + 1)*sizeof(uint32_t));
+	C.capacity = INITIAL_TABLE_SIZE;
+	C.name = malloc(C.capacity*sizeof(uint32_t));
+	assert(C.node != NULL && C.name != NULL);
+	memset(C.node, 0xFF, (numNames + 1)*sizeof(uint32_t));
+	
+	for (i=from; i<count; i++) {
+		rec = &records[i];
+	
+		// a faulty line has no names, and a name outside the dictionary
+		// makes a line faulty as well
+		INSTR_COUNT(COUNT_LINES, 1);
+		if (rec->actor >= numNames || rec->target >= numNames) {
+			INSTR_COUNT(COUNT_FAULTY, 1);
+			continue;
+		}
+		
+		// The reorder buffer copies the names of the events it holds,
+		// so they go through it by name.
+		if (X != NULL) {
+			ev.time = rec->time;
+			eventlog_name(L, rec->actor, &ev.actor);
+			eventlog_name(L, rec->target, &ev.target);
+			reorderEvent(G, X, &ev);
+			continue;
+		}
+		
+		if (engine_admit(G, rec->time)) {
+			INSTR_START(tLookup);
+			idA = nodeOfName(G, &C, rec->actor);
+			idT = nodeOfName(G, &C, rec->target);
+			INSTR_STOP(STAGE_LOOKUP, tLookup);
+			engine_link(G, idA, idT, rec->time);
+		}
+		engine_stats(G, &stats);
+		emitDirect(out, &stats);
+		snapshotLine(G, SN, i + 1);
+	}
+	
+	if (X != NULL)
+		reorderEnd(G, X);
+	
+	free(C.node);
+	free(C.name);
+}
+
+int main(int argc, char* argv[]) {
+	
+	writer* fp_out;
+	reader* fp_in;
+	FILE* fp_info = stdout;	// where the timing is reported
+	
+	int medianAlg = 2;	// Set to 1 to use the naiveMedian algorithm
+						// Can also be set by the user with the 3rd
+						// argument to the executable
+	
+	int printEntry = 0;		// After which entry to print the graph
+	
+	char* inPath = "input.txt";	// the input file, opened again by the pipeline
+	if (argc > 1)
+		inPath = argv[1];
+	
+	// the windows of the medians, MAX_AGE by default
+	windowSet windows;
+	windows.count = 1;
+	windows.ages[0] = MAX_AGE;
+	if (argc > 5 && !parseWindows(argv[5], &windows)) {
+		printf("\n\nERROR: invalid windows; give up to %d lengths in seconds, separated by commas\n\n", MAX_WINDOWS);
+		exit(0);
+	}
+	
+	// the interval of the snapshots
+	long int snapInterval = snapshotInterval();
+	if (snapInterval < 0) {
+		printf("\n\nERROR: invalid VENGRAPH_SNAPSHOT_INTERVAL; set a number of lines, or 0 for no snapshots\n\n");
+		exit(0);
+	}
+	
+	// Parse the user inputs
+	// First is the input file
+	// Second is the output file
+	// Third is the median algorithm (1 slow, 2 fast)
+	// Fourth is the input file line after which to print the graph
+	// Fifth is the list of windows, parsed above
+	// exit() rather than abort is used after bad inputs because at 
+	// this point the program hasn't done anything a core dump might
+	// illuminate
+	switch (argc) {
+		case 1:
+			fp_in = reader_open("input.txt");
+			if (fp_in == NULL) { printf("\n\nERROR: default input file could not be opened\n\n"); exit(0); }
+			fp_out = writer_open("output.txt");
+			if (fp_out == NULL) { printf("\n\nERROR: default output file could not be opened\n\n"); reader_close(fp_in); exit(0); }
+			break;
+		case 2:
+			fp_in = reader_open(argv[1]);
+			if (fp_in == NULL) { 
+				printf("\n\nERROR: user input file could not be opened\n\n"); 
+				exit(0); 
+			}
+			fp_out = writer_open("output.txt");
+			if (fp_out == NULL) { 
+				printf("\n\nERROR: default output file could not be opened\n\n"); 
+				reader_close(fp_in); 
+				exit(0);
+			}
+			break;
+		case 3:
+			fp_in = reader_open(argv[1]);
+			if (fp_in == NULL) { 
+				printf("\n\nERROR: user input file could not be opened\n\n"); 
+				exit(0); 
+			}
+			fp_out = writer_open(argv[2]);
+			if (fp_out == NULL) { 
+				printf("\n\nERROR: user output file could not be opened\n\n");  
+				reader_close(fp_in); 
+				exit(0);
+			}
+			break;
+		case 4:
+			fp_in = reader_open(argv[1]);
+			if (fp_in == NULL) { 
+				printf("\n\nERROR: user input file could not be opened\n\n"); 
+				exit(0); 
+			}
+			fp_out = writer_open(argv[2]);
+			if (fp_out == NULL) { 
+				printf("\n\nERROR: user output file could not be opened\n\n"); 
+				reader_close(fp_in);
+				exit(0); 
+			}
+			medianAlg = atoi(argv[3]);
+			if (medianAlg != 1 && medianAlg != 2) { 
+				printf("\n\nERROR: invalid median algorithm; set 1 or 2\n\n"); 
+				reader_close(fp_in);
+				writer_close(fp_out);
+				exit(0);
+			}
+			break;
+		case 5:
+		case 6:
+			fp_in = reader_open(argv[1]);
+			if (fp_in == NULL) { 
+				printf("\n\nERROR: user input file could not be opened\n\n"); 
+				exit(0); 
+			}
+			fp_out = writer_open(argv[2]);
+			if (fp_out == NULL) { 
+				printf("\n\nERROR: user output file could not be opened\n\n"); 
+				reader_close(fp_in);
+				exit(0); 
+			}
+			medianAlg = atoi(argv[3]);
+			if (medianAlg != 1 && medianAlg != 2) { 
+				printf("\n\nERROR: invalid median algorithm; set 1 or 2\n\n"); 
+				reader_close(fp_in);
+				writer_close(fp_out);
+				exit(0);
+			}
+			printEntry = atoi(argv[4]);
+			break;
+		default:
+			printf("\nERROR: faulty number of inputs\n\n");
+			exit(0);
+			break;
+	}
+	
+	INSTR_BEGIN();
+	
+	engine* G = engine_create(&windows, medianAlg, printEntry);
+	engine_setBudget(G, MEMORY_BUDGET);
+	
+	// the memory of the graph, if it is held to a budget or reported
+	int metered = (MEMORY_BUDGET > 0 || REPORT_MEMORY);
+	engineMemory memory;
+	
+	// the time spent on the medians by the engines of the shards or the
+	// workers of the backfill, on top of that of G
+	float medianTime = 0;
+	
+	statsLine stats;
+	
+	// The input parser. The actor and target of an event point
+	// into the line itself, so nothing is copied.
+	parser* PRS = parser_create();
+	venmoEvent ev;
+	
+	char* line;		// line of the input file, not terminated
+	int lineLen;	// and its length
+	
+	// If the input is a stream, the medians are flushed in batches as 
+	// they are computed, rather than whenever the stdio buffer fills up.
+	// The graph simply lives on between the lines of the stream.
+	int streaming = reader_isStream(fp_in);
+	directOutput out;
+	out.W = fp_out;
+	out.streaming = streaming;
+	out.batch.pending = 0;
+	
+	// the state of the reorder mode, if it is on
+	reorderState order;
+	int reordering = (REORDER_LATENESS > 0);
+	if (reordering) {
+		reorderInit(&order);
+		order.emit = emitDirect;
+		order.ctx = &out;
+	}
+	
+	// A regular input file can be an event log written by venConvert, which
+	// is replayed without parsing.
+	eventlog* LOG = NULL;
+	if (!streaming)
+		LOG = eventlog_open(inPath);
+	
+	// the timing report must not end up in the medians
+	if (argc > 2 && strcmp(argv[2], "-") == 0)
+		fp_info = stderr;
+	
+	// The snapshots, and the graph of the last one, if there is one.
+	// A file is taken up where the snapshot left off, and a stream is taken
+	// to go on from there, i.e. the upstream sends the input from that
+	// offset on again.
+	snapshotState snap;
+	snapshotInit(&snap, snapInterval, !reordering);
+	long long int from = 0;
+	if (snap.on && (from = resumeGraph(G, &snap)) >= 0) {
+		fprintf(fp_info, "\nResumed from %s after %lu lines of the output, at offset %lld of the input\n", SNAPSHOT_PATH, snap.lines, from);
+		if (streaming) {
+			snap.base = from;
+		}
+		else if (LOG == NULL) {
+			reader_close(fp_in);
+			fp_in = reader_openRange(inPath, from, -1);
+			if (fp_in == NULL) {
+				printf("\n\nERROR: user input file could not be opened again\n\n");
+				exit(0);
+			}
+		}
+	}
+	if (from < 0)
+		from = 0;
+	
+	// A regular file is replayed by the pipeline of threads, or in chunks by
+	// the backfill, and a stream is processed line by line in this thread,
+	// as the lines come in.
+	// The backfill cannot print the graph after a given line, and the ranking
+	// of the top nodes of equal degree depends on the whole history, so
+	// neither of them is used with it.
+	// The graph is only split into shards if nothing needs all of it in
+	// one place: neither the names of the top nodes, nor the naive median,
+	// nor the graph printer. The merger only keeps the histogram of one
+	// window, so there must be just one.
+	// Neither the backfill nor the shards reorder the events, take
+	// snapshots, or keep to a memory budget.
+	// An event log has nothing left to parse, so it is replayed in this
+	// thread alone.
+	if (LOG != NULL) {
+		runLog(G, LOG, from, &out, reordering ? &order : NULL, &snap);
+		eventlog_close(LOG);
+	}
+	else if (!streaming && BACKFILL_WORKERS > 1 && TOP_K == 0 && printEntry == 0 && !reordering && !snap.on && !metered) {
+		medianTime = runBackfill(G, inPath, fp_in, fp_out, BACKFILL_WORKERS);
+	}
+	else if (!streaming && PIPELINE_PARSERS > 0 && GRAPH_SHARDS > 1 && TOP_K == 0 && medianAlg == 2 && printEntry == 0 && !reordering && !snap.on && !metered && engine_numWindows(G) == 1) {
+		medianTime = runSharded(G, inPath, fp_in, fp_out);
+	}
+	else if (!streaming && PIPELINE_PARSERS > 0) {
+		runPipeline(G, inPath, from, fp_in, fp_out, reordering ? &order : NULL, &snap);
+	}
+	else {
+		// go through every line of the input file
+		for (;;) {
+			
+			// Before waiting for more of a stream, flush the medians
+			// that have been computed so far.
+			if (streaming && out.batch.pending > 0 && !reader_ready(fp_in))
+				flushOutput(fp_out, &out.batch);
+			
+			if (!reader_next(fp_in, &line, &lineLen))
+				break;
+			
+			// skip the input line if it is faulty
+			if (!parser_parse(PRS, line, lineLen, &ev))
+				continue;
+			
+			if (reordering) {
+				reorderEvent(G, &order, &ev);
+			}
+			else {
+				engine_ingest(G, &ev, &stats);
+				emitDirect(&out, &stats);
+				snapshotLine(G, &snap, reader_offset(fp_in) + lineLen);
+			}
+		}
+		
+		if (reordering)
+			reorderEnd(G, &order);
+	}
+	
+	reader_close(fp_in);
+	writer_close(fp_out);
+	
+	// the last snapshot holds the graph at the end of the input
+	if (snap.on)
+		takeSnapshot(G, &snap, 1);
+
+	parser_destroy(PRS);
+	medianTime = medianTime + engine_medianTime(G);
+	engine_memory(G, &memory);
+	engine_destroy(G);
+	
+	fprintf(fp_info, "\nTotal median computation time:\t%.8f seconds\n\n",medianTime);
+	
+	if (metered) {
+		fprintf(fp_info, "Memory of the graph at the end:\t%zu bytes (names %zu, lists %zu, blocks %zu, expiry %zu, edges %zu)\n",
+			memory.total, memory.names, memory.lists, memory.blocks, memory.expiry, memory.edges);
+		if (memory.budget > 0)
+			fprintf(fp_info, "Memory budget:\t%zu bytes, %zu at the peak; %lu branches evicted early, %lu events rejected\n",
+				memory.budget, memory.peak, memory.evicted, memory.rejected);
+		fprintf(fp_info, "\n");
+	}
+	
+	// the instrumentation, if it is compiled in, has the rest of the story
+	INSTR_FINISH();
+	if (INSTRUMENT)
+		fprintf(fp_info, "Stage timings and counters:\t%s\n\n", STATS_PATH);
+	
+	if (reordering) {
+		fprintf(fp_info, "Late events (older than the watermark):\t%lu\n\n", reorder_late(order.buffer));
+		reorderFree(&order);
+	}
+	
+	return 0;
+}
@@ -0,0 +1,233 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "parser.h"
+#include "instrument.h"
+#include "venmoGraphParams.h"
+
+// length of a time code such as 2016-03-28T23:23:12Z
+#define TIME_CODE_LEN 20
+
+// length of the part of the time code up to the minutes, 2016-03-28T23:23
+#define TIME_MINUTE_LEN 16
+
+struct parserPrototype {
+
+	// the date, hour and minute of the last time code, and the
+	// seconds since the epoch at the start of that minute.
+	// consecutive lines usually share the minute, so the calendar
+	// arithmetic is skipped for them
+	char lastMinute[TIME_MINUTE_LEN];
+	unsigned long int lastMinuteTime;
+};
+
+parser* parser_create() {
+
+	parser* P = malloc(sizeof(parser));
+	assert(P != NULL);
+
+	memset(P->lastMinute, 0, TIME_MINUTE_LEN);
+	P->lastMinuteTime = 0;
+
+	return P;
+}
+
+void parser_destroy(parser* P) {
+	free(P);
+}
+
+// number of days from 1970-01-01 to the given date of the proleptic
+// Gregorian calendar. the years are shifted to start in March, so the
+// leap day is the last day of the year.
+static long daysFromCivil(int year, int month, int day) {
+
+	year = year - (month <= 2);
+
+	long era = (year >= 0 ? year : year - 399) / 400;
+	long yoe = year - era*400;									// [0, 399]
+	long doy = (153*(month + (month > 2 ? -3 : 9)) + 2)/5 + day - 1;	// [0, 365]
+	long doe = yoe*365 + yoe/4 - yoe/100 + doy;					// [0, 146096]
+
+	return era*146097 + doe - 719468;
+}
+
+// number of days in the given month, with the leap years of the
+// Gregorian calendar
+static int daysInMonth(int year, int month) {
+
+	static const int days[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+
+	if (month == 2 && year % 4 == 0 && (year % 100 != 0 || year % 400 == 0))
+		return 29;
+	return days[month - 1];
+}
+
+// read n digits into *val. 0 is returned if one of them is not a digit
+static int readDigits(const char* s, int n, int* val) {
+
+	int i;
+	*val = 0;
+	for (i=0; i<n; i++) {
+		if (s[i] < '0' || s[i] > '9')
+			return 0;
+		*val = *val*10 + (s[i] - '0');
+	}
+	return 1;
+}
+
+// convert a time code of the form YYYY-MM-DDTHH:MM:SSZ to seconds since
+// the epoch. the Z means UTC, so there are no time zones or daylight
+// saving to consider, and the conversion is plain arithmetic.
+// 0 is returned if the time code is faulty
+static unsigned long int parseTime(parser* P, const char* s, int len) {
+
+	int year, month, day, hour, minute, second;
+
+	if (len != TIME_CODE_LEN)
+		return 0;
+	if (s[4] != '-' || s[7] != '-' || s[10] != 'T' || s[13] != ':' || s[16] != ':' || s[19] != 'Z')
+		return 0;
+	if (!readDigits(s+17, 2, &second) || second > 60)
+		return 0;
+
+	if (memcmp(s, P->lastMinute, TIME_MINUTE_LEN) == 0)
+		return P->lastMinuteTime + second;
+
+	if (!readDigits(s, 4, &year) || !readDigits(s+5, 2, &month) || !readDigits(s+8, 2, &day) ||
+		!readDigits(s+11, 2, &hour) || !readDigits(s+14, 2, &minute))
+		return 0;
+
+	if (month < 1 || month > 12 || hour > 23 || minute > 59 || year < 1970)
+		return 0;
+	if (day < 1 || day > daysInMonth(year, month))
+		return 0;
+
+	memcpy(P->lastMinute, s, TIME_MINUTE_LEN);
+	P->lastMinuteTime = (unsigned long int)daysFromCivil(year, month, day)*86400 + hour*3600 + minute*60;
+
+	return P->lastMinuteTime + second;
+}
+
+static char* skipSpace(char* p, char* end) {
+	while (p < end && (*p == ' ' || *p == '\t'))
+		p++;
+	return p;
+}
+
+// p is at an opening quote. find the closing quote of the string, skipping
+// escaped quotes. memchr is used because the C library searches many bytes
+// at a time with vector instructions.
+static char* closingQuote(char* p, char* end) {
+
+	char* q = p + 1;
+	char* b;
+
+	while ((q = memchr(q, '"', end - q)) != NULL) {
+		// the quote is escaped if it follows an odd number of backslashes
+		b = q;
+		while (b > p + 1 && *(b-1) == '\\')
+			b--;
+		if ((q - b) % 2 == 0)
+			return q;
+		q++;
+	}
+	return NULL;
+}
+
+static int parseLine(parser* P, char* line, int len, venmoEvent* ev) {
+
+	// The line must be one JSON object of string values, such as
+	//   {"created_time": "2016-03-28T23:23:12Z", "target": "Raffi-Antilian", "actor": "Amber-Sauer"}
+	// The keys may come in any order, and other keys are skipped. 
+	// The line is faulty if the object is malformed, if any of the three
+	// keys is missing, or if any of their values is empty or malformed.
+
+	char* p = line;
+	char* end = line + len;
+	char* q;
+	char* key;
+	char* val;
+	int keyLen;
+	int valLen;
+
+	ev->time = 0;
+	ev->actor.str = NULL;
+	ev->actor.len = 0;
+	ev->target.str = NULL;
+	ev->target.len = 0;
+
+	// the newline (and a carriage return) is not part of the object
+	while (end > p && (*(end-1) == '\n' || *(end-1) == '\r'))
+		end--;
+
+	p = skipSpace(p, end);
+	if (p == end || *p != '{')
+		return 0;
+	p = skipSpace(p + 1, end);
+
+	while (p < end && *p != '}') {
+
+		// "key"
+		if (*p != '"' || (q = closingQuote(p, end)) == NULL)
+			return 0;
+		key = p + 1;
+		keyLen = q - key;
+
+		// :
+		p = skipSpace(q + 1, end);
+		if (p == end || *p != ':')
+			return 0;
+
+		// "value"
+		p = skipSpace(p + 1, end);
+		if (p == end || *p != '"' || (q = closingQuote(p, end)) == NULL)
+			return 0;
+		val = p + 1;
+		valLen = q - val;
+
+		if (keyLen == 12 && memcmp(key, "created_time", 12) == 0) {
+			ev->time = parseTime(P, val, valLen);
+		}
+		else if (keyLen == 6 && memcmp(key, "target", 6) == 0) {
+			ev->target.str = val;
+			ev->target.len = valLen;
+		}
+		else if (keyLen == 5 && memcmp(key, "actor", 5) == 0) {
+			ev->actor.str = val;
+			ev->actor.len = valLen;
+		}
+
+		// , or }
+		p = skipSpace(q + 1, end);
+		if (p < end && *p == ',') {
+			p = skipSpace(p + 1, end);
+			if (p < end && *p == '}')
+				return 0;
+		}
+		else if (p == end || *p != '}')
+			return 0;
+	}
+
+	if (p == end)
+		return 0;
+
+	// the names must fit in the buffers of the rest of the program
+	if (ev->actor.len == 0 || ev->actor.len >= MAX_STR_LEN)
+		return 0;
+	if (ev->target.len == 0 || ev->target.len >= MAX_STR_LEN)
+		return 0;
+
+	return ev->time != 0;
+}
+
+int parser_parse(parser* P, char* line, int len, venmoEvent* ev) {
+
+	INSTR_START(t);
+	int valid = parseLine(P, line, len, ev);
+	INSTR_STOP(STAGE_PARSE, t);
+	
+	INSTR_COUNT(COUNT_LINES, 1);
+	INSTR_COUNT(COUNT_FAULTY, !valid);
+	return valid;
+}
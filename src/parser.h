@@ -0,0 +1,30 @@
+#ifndef _parser_h
+#define _parser_h
+
+typedef struct parserPrototype parser;
+
+// A name inside an input line. The parser does not copy or terminate the
+// name, so it is only valid for as long as the line is.
+typedef struct {
+	char* str;
+	int   len;
+} nameView;
+
+// A parsed input line
+typedef struct {
+	unsigned long int time;		// seconds since the epoch (UTC)
+	nameView actor;
+	nameView target;
+} venmoEvent;
+
+// create and destroy a parser. a parser remembers the last time code it
+// converted, so every thread that parses needs its own parser
+parser* parser_create();
+void parser_destroy(parser* P);
+
+// parse the line of length len (a trailing newline is allowed) into the event
+// 1 is returned if the line is a valid event, 0 if it is faulty
+// the rules for faulty lines are explained in the readme
+int parser_parse(parser* P, char* line, int len, venmoEvent* ev);
+
+#endif
@@ -0,0 +1,105 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include "pool.h"
+#include "venmoGraphParams.h"
+
+// A slab has the following structure in memory:
+//    | nextSlab | record | record | ... | record |
+// The slabs of a pool are linked through nextSlab so that they can all
+// be freed at once. A free record holds the address of the next free
+// record in its first bytes, so the free list costs no extra memory.
+
+struct poolPrototype {
+
+	void* slabs;		// most recent slab
+	void* freeRecs;		// first free record
+
+	int recordSize;
+	int recordsPerSlab;
+
+	size_t count_used;	// records handed out and not given back
+};
+
+pool* pool_create(int recordSize) {
+
+	assert(recordSize > 0);
+
+	pool* P = malloc(sizeof(pool));
+	assert(P != NULL);
+
+	// every record must be able to hold the free list pointer, and
+	// records are aligned to pointers
+	if (recordSize < (int)sizeof(void*))
+		recordSize = sizeof(void*);
+	P->recordSize = (recordSize + sizeof(void*) - 1) / sizeof(void*) * sizeof(void*);
+
+	P->recordsPerSlab = (POOL_SLAB_SIZE - sizeof(void*)) / P->recordSize;
+	if (P->recordsPerSlab < 1)
+		P->recordsPerSlab = 1;
+
+	P->slabs = NULL;
+	P->freeRecs = NULL;
+	P->count_used = 0;
+
+	return P;
+}
+
+void pool_destroy(pool* P) {
+
+	void* slab = P->slabs;
+	void* nextSlab;
+
+	while (slab != NULL) {
+		nextSlab = *(void**)slab;
+		free(slab);
+		slab = nextSlab;
+	}
+	free(P);
+}
+
+// allocate a new slab and put all of its records on the free list
+static void pool_grow(pool* P) {
+
+	char* slab = malloc(sizeof(void*) + (size_t)P->recordsPerSlab * P->recordSize);
+
+	if (slab == NULL) {
+		printf("\n\nFATAL ERROR: cannot allocate a new slab of records\n\n");
+		abort();
+	}
+
+	*(void**)slab = P->slabs;
+	P->slabs = slab;
+
+	// thread the records from the last to the first, so that they are
+	// handed out in the order of their addresses
+	char* rec;
+	int i;
+	for (i=P->recordsPerSlab-1; i>=0; i--) {
+		rec = slab + sizeof(void*) + (size_t)i * P->recordSize;
+		*(void**)rec = P->freeRecs;
+		P->freeRecs = rec;
+	}
+}
+
+void* pool_alloc(pool* P) {
+
+	if (P->freeRecs == NULL)
+		pool_grow(P);
+
+	void* rec = P->freeRecs;
+	P->freeRecs = *(void**)rec;
+	P->count_used++;
+
+	return rec;
+}
+
+void pool_free(pool* P, void* rec) {
+	*(void**)rec = P->freeRecs;
+	P->freeRecs = rec;
+	P->count_used--;
+}
+
+size_t pool_bytes(pool* P) {
+	return P->count_used * P->recordSize;
+}
@@ -0,0 +1,25 @@
+#ifndef _pool_h
+#define _pool_h
+
+#include <stddef.h>
+
+typedef struct poolPrototype pool;
+
+// create a pool of fixed size records by specifying the size of a record
+// records are cut out of large slabs (POOL_SLAB_SIZE in venmoGraphParams)
+// and freed records are kept on a free list to be handed out again
+pool* pool_create(int recordSize);
+
+// release every slab of the pool at once, with all the records in them
+void pool_destroy(pool* P);
+
+// get a record from the pool, and give it back
+void* pool_alloc(pool* P);
+void pool_free(pool* P, void* rec);
+
+// the bytes of the records handed out and not given back yet
+// (the slabs also hold the free records, which are never more than the
+// records in use at the peak)
+size_t pool_bytes(pool* P);
+
+#endif
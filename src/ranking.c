@@ -0,0 +1,125 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "ranking.h"
+
+// The nodes of one degree form a doubly linked list. The links are kept in
+// arrays indexed by node id, like the lists of the graph, and the first node
+// of every degree is kept in an array indexed by degree.
+
+struct rankingPrototype {
+
+	uint32_t* head;		// first node of every degree
+	int maxDegree;		// size of head
+
+	uint32_t* next;
+	uint32_t* prev;
+	int capacity;		// number of node ids next and prev can hold
+};
+
+// grow an array of ids to newSize and mark the new ids as missing
+static uint32_t* growIds(uint32_t* arr, int oldSize, int newSize) {
+
+	arr = realloc(arr, newSize*sizeof(uint32_t));
+	if (arr == NULL) {
+		printf("\n\nFATAL ERROR: cannot expand the ranking\n\n");
+		abort();
+	}
+	memset(arr + oldSize, 0xFF, (newSize - oldSize)*sizeof(uint32_t));
+	return arr;
+}
+
+ranking* ranking_create(int initCapacity) {
+
+	assert(initCapacity > 0);
+
+	ranking* R = malloc(sizeof(ranking));
+	assert(R != NULL);
+
+	R->capacity = initCapacity;
+	R->next = growIds(NULL, 0, initCapacity);
+	R->prev = growIds(NULL, 0, initCapacity);
+
+	R->maxDegree = initCapacity;
+	R->head = growIds(NULL, 0, initCapacity + 1);
+
+	return R;
+}
+
+void ranking_destroy(ranking* R) {
+	free(R->head);
+	free(R->next);
+	free(R->prev);
+	free(R);
+}
+
+size_t ranking_bytes(ranking* R) {
+	return sizeof(ranking) + ((size_t)R->maxDegree + 1 + 2*(size_t)R->capacity)*sizeof(uint32_t);
+}
+
+void ranking_move(ranking* R, uint32_t id, int oldDegree, int newDegree) {
+
+	int newSize;
+
+	// unlink the node from the list of its old degree
+	if (oldDegree > 0) {
+		if (R->prev[id] == RANKING_NONE)
+			R->head[oldDegree] = R->next[id];
+		else
+			R->next[R->prev[id]] = R->next[id];
+
+		if (R->next[id] != RANKING_NONE)
+			R->prev[R->next[id]] = R->prev[id];
+	}
+
+	if (newDegree == 0)
+		return;
+
+	// make room, doubling like the lists do
+	if (id >= (uint32_t)R->capacity) {
+		newSize = R->capacity;
+		while (id >= (uint32_t)newSize)
+			newSize = newSize*2;
+		R->next = growIds(R->next, R->capacity, newSize);
+		R->prev = growIds(R->prev, R->capacity, newSize);
+		R->capacity = newSize;
+	}
+	if (newDegree > R->maxDegree) {
+		newSize = R->maxDegree;
+		while (newDegree > newSize)
+			newSize = newSize*2;
+		R->head = growIds(R->head, R->maxDegree + 1, newSize + 1);
+		R->maxDegree = newSize;
+	}
+
+	// link it on top of the list of its new degree
+	R->prev[id] = RANKING_NONE;
+	R->next[id] = R->head[newDegree];
+	if (R->head[newDegree] != RANKING_NONE)
+		R->prev[R->head[newDegree]] = id;
+	R->head[newDegree] = id;
+}
+
+int ranking_top(ranking* R, degrees* D, int k, uint32_t* ids, int* degs) {
+
+	// Most degrees have no nodes at all, so rather than counting down
+	// through the degrees, the histogram tells us the next degree that
+	// has nodes: the degree of the highest node not taken yet.
+
+	int rank = degrees_count(D);
+	int found = 0;
+	int degree;
+	uint32_t id;
+
+	while (found < k && rank > 0) {
+		degree = degrees_select(D, rank);
+		for (id = R->head[degree]; id != RANKING_NONE && found < k; id = R->next[id]) {
+			ids[found] = id;
+			degs[found] = degree;
+			found++;
+			rank--;
+		}
+	}
+	return found;
+}
@@ -0,0 +1,35 @@
+#ifndef _ranking_h
+#define _ranking_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include "degrees.h"
+
+#define RANKING_NONE 0xFFFFFFFFu
+
+typedef struct rankingPrototype ranking;
+
+// The ranking groups the nodes by their degree: all the nodes of the same
+// degree are linked together, so the nodes of the highest degrees are found
+// without looking at the others.
+
+// create the ranking, with room for initCapacity node ids
+// (it grows by itself when a larger id or degree shows up)
+ranking* ranking_create(int initCapacity);
+
+// destroy the ranking
+void ranking_destroy(ranking* R);
+
+// the bytes the ranking holds
+size_t ranking_bytes(ranking* R);
+
+// move node "id" from oldDegree to newDegree
+// a degree of 0 means that the node is not ranked
+void ranking_move(ranking* R, uint32_t id, int oldDegree, int newDegree);
+
+// write the ids and degrees of up to k nodes of the highest degrees into
+// ids and degs, highest first. the histogram D must hold the same degrees.
+// the number of nodes written is returned
+int ranking_top(ranking* R, degrees* D, int k, uint32_t* ids, int* degs);
+
+#endif
@@ -0,0 +1,273 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include "reader.h"
+#include "venmoGraphParams.h"
+
+// initial size of the buffer when the input is read rather than mapped.
+// the buffer doubles whenever a single line does not fit
+#define READ_BLOCK_SIZE 65536
+
+struct readerPrototype {
+
+	int fd;
+
+	// the whole file when it is mapped, or the buffer when it is read
+	char* data;
+	size_t size;
+	int mapped;
+
+	// the part of the data that has not been handed out yet
+	size_t pos;
+	size_t end;
+
+	// the end of the next line, if reader_ready has already found it
+	size_t next;
+
+	int eof;
+	int stream;
+
+	// the offset in the file of data[0], which changes as the buffer is
+	// refilled, and the offset of the line handed out last
+	long long int base;
+	long long int offset;
+
+	// lines starting at this offset or later are not handed out (-1: none)
+	long long int limit;
+
+	long long int fileSize;
+};
+
+reader* reader_open(char* path) {
+
+	struct stat st;
+
+	int fd;
+	if (strcmp(path, "-") == 0)
+		fd = STDIN_FILENO;
+	else
+		fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return NULL;
+
+	reader* R = malloc(sizeof(reader));
+	assert(R != NULL);
+
+	R->fd = fd;
+	R->pos = 0;
+	R->end = 0;
+	R->next = 0;
+	R->eof = 0;
+	R->mapped = 0;
+	R->stream = 0;
+	R->data = NULL;
+	R->base = 0;
+	R->offset = 0;
+	R->limit = -1;
+
+	if (fstat(fd, &st) != 0)
+		st.st_size = 0;
+	else if (!S_ISREG(st.st_mode))
+		R->stream = 1;
+	R->fileSize = R->stream ? 0 : st.st_size;
+
+	// Map a regular file in one piece and tell the kernel that it will be
+	// read from front to back, so that it reads ahead aggressively. 
+	// An empty file cannot be mapped, but it has no lines anyway.
+	if (INPUT_MMAP && !R->stream && st.st_size > 0) {
+		R->data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (R->data != MAP_FAILED) {
+			posix_madvise(R->data, st.st_size, POSIX_MADV_SEQUENTIAL);
+			R->mapped = 1;
+			R->size = st.st_size;
+			R->end = st.st_size;
+			R->eof = 1;
+			return R;
+		}
+	}
+
+	R->size = READ_BLOCK_SIZE;
+	R->data = malloc(R->size);
+	assert(R->data != NULL);
+
+	return R;
+}
+
+void reader_close(reader* R) {
+
+	if (R->mapped)
+		munmap(R->data, R->size);
+	else
+		free(R->data);
+
+	if (R->fd != STDIN_FILENO)
+		close(R->fd);
+	free(R);
+}
+
+int reader_isStream(reader* R) {
+	return R->stream;
+}
+
+// read more of the input into the buffer, after the unfinished line
+// 0 is returned at the end of the input
+static int fill(reader* R) {
+
+	ssize_t n;
+
+	// move the unfinished line to the front of the buffer
+	if (R->pos > 0) {
+		memmove(R->data, R->data + R->pos, R->end - R->pos);
+		R->base = R->base + R->pos;
+		R->end = R->end - R->pos;
+		R->pos = 0;
+	}
+
+	// the line fills the whole buffer, so the buffer must grow
+	if (R->end == R->size) {
+		R->size = R->size*2;
+		R->data = realloc(R->data, R->size);
+		if (R->data == NULL) {
+			printf("\n\nFATAL ERROR: cannot expand the input buffer\n\n");
+			abort();
+		}
+	}
+
+	// a stream hands over whatever has arrived, which may be less than
+	// the buffer, so a line is processed as soon as it is complete
+	do {
+		n = read(R->fd, R->data + R->end, R->size - R->end);
+	} while (n < 0 && errno == EINTR);
+	
+	if (n <= 0) {
+		R->eof = 1;
+		return 0;
+	}
+	R->end = R->end + n;
+	return 1;
+}
+
+int reader_ready(reader* R) {
+
+	char* nl;
+
+	if (R->eof || R->next > 0)
+		return 1;
+
+	// remember where the line ends, so reader_next does not search again
+	nl = memchr(R->data + R->pos, '\n', R->end - R->pos);
+	if (nl == NULL)
+		return 0;
+	R->next = nl - R->data + 1;
+	return 1;
+}
+
+// get the next line, regardless of the range
+static int nextLine(reader* R, char** line, int* len) {
+
+	// The end of the line is found with memchr, which the C library
+	// implements with vector instructions.
+
+	char* start;
+	char* nl;
+
+	if (R->next > 0) {
+		*line = R->data + R->pos;
+		*len = R->next - R->pos;
+		R->pos = R->next;
+		R->next = 0;
+		return 1;
+	}
+
+	for (;;) {
+		start = R->data + R->pos;
+		nl = memchr(start, '\n', R->end - R->pos);
+
+		if (nl != NULL) {
+			*line = start;
+			*len = nl - start + 1;
+			R->pos = R->pos + *len;
+			return 1;
+		}
+
+		// no newline in the data we have. at the end of the input the
+		// rest is the last line, otherwise we read more
+		if (R->eof || !fill(R)) {
+			if (R->pos == R->end)
+				return 0;
+			*line = R->data + R->pos;
+			*len = R->end - R->pos;
+			R->pos = R->end;
+			return 1;
+		}
+	}
+}
+
+int reader_next(reader* R, char** line, int* len) {
+
+	if (!nextLine(R, line, len))
+		return 0;
+
+	R->offset = R->base + (*line - R->data);
+
+	// the rest of the file belongs to the next range
+	if (R->limit >= 0 && R->offset >= R->limit) {
+		R->pos = R->end;
+		R->next = 0;
+		R->eof = 1;
+		return 0;
+	}
+	return 1;
+}
+
+reader* reader_openRange(char* path, long long int from, long long int to) {
+
+	char* line;
+	int len;
+
+	reader* R = reader_open(path);
+	if (R == NULL)
+		return NULL;
+	assert(!R->stream);
+
+	R->limit = to;
+
+	if (from > R->fileSize)
+		from = R->fileSize;
+
+	// Start at the byte before the range, and skip the line that contains
+	// it: that line started in the range before. If the byte is a newline,
+	// the first line of the range starts right after it, and only the
+	// newline is skipped.
+	if (from > 0) {
+		if (R->mapped) {
+			R->pos = from - 1;
+		}
+		else {
+			if (lseek(R->fd, from - 1, SEEK_SET) < 0) {
+				reader_close(R);
+				return NULL;
+			}
+			R->base = from - 1;
+		}
+		nextLine(R, &line, &len);
+	}
+	return R;
+}
+
+long long int reader_size(reader* R) {
+	return R->fileSize;
+}
+
+long long int reader_offset(reader* R) {
+	return R->offset;
+}
@@ -0,0 +1,40 @@
+#ifndef _reader_h
+#define _reader_h
+
+typedef struct readerPrototype reader;
+
+// open the input file at path, or the standard input if the path is "-"
+// a regular file is memory-mapped if INPUT_MMAP is set in venmoGraphParams,
+// anything else (or a file that cannot be mapped) is read in large blocks
+// NULL is returned if the file cannot be opened
+reader* reader_open(char* path);
+
+// open a regular file to read only the lines that start at a byte offset in
+// [from, to), or up to the end of the file if to < 0. a line that starts
+// before "from" belongs to the range before, even if it ends inside this one,
+// so splitting a file at any offsets hands out every line exactly once
+reader* reader_openRange(char* path, long long int from, long long int to);
+
+// the size in bytes of a regular file (0 for a stream)
+long long int reader_size(reader* R);
+
+// 1 if the input is a stream (a pipe, a FIFO, a terminal or a socket),
+// whose lines arrive while the program runs, 0 if it is a regular file
+int reader_isStream(reader* R);
+
+// 1 if the next call to reader_next returns without waiting for the input,
+// i.e. a whole line is already buffered or the input has ended
+int reader_ready(reader* R);
+
+// close the input file
+void reader_close(reader* R);
+
+// get the next line of the input, of any length, including its newline
+// the line is not terminated and is only valid until the next call
+// 1 is returned if there is a line, 0 at the end of the input
+int reader_next(reader* R, char** line, int* len);
+
+// the byte offset in the file of the line last returned by reader_next
+long long int reader_offset(reader* R);
+
+#endif
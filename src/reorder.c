@@ -0,0 +1,182 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "reorder.h"
+#include "pool.h"
+#include "venmoGraphParams.h"
+
+// An event waiting in the buffer, with copies of its names
+typedef struct {
+	unsigned long int time;
+	unsigned long int seq;
+	int actorLen;
+	int targetLen;
+	char actor[MAX_STR_LEN];
+	char target[MAX_STR_LEN];
+} entry_t;
+
+#define INIT_HEAP_CAP 64
+
+struct reorderPrototype {
+
+	// the waiting events, in a binary min-heap ordered by (time, seq)
+	entry_t** heap;
+	int count;
+	int capacity;
+
+	pool* entries;
+
+	// the entry handed out by the last pop, given back on the next call
+	entry_t* popped;
+
+	unsigned long int lateness;
+	unsigned long int maxTime;	// the largest time stamp seen so far
+	int flushing;				// the input has ended
+
+	unsigned long int late;
+};
+
+reorder* reorder_create(int lateness) {
+
+	assert(lateness >= 0);
+
+	reorder* B = malloc(sizeof(reorder));
+	assert(B != NULL);
+
+	B->capacity = INIT_HEAP_CAP;
+	B->count = 0;
+	B->heap = malloc(B->capacity*sizeof(entry_t*));
+	assert(B->heap != NULL);
+
+	B->entries = pool_create(sizeof(entry_t));
+	B->popped = NULL;
+
+	B->lateness = lateness;
+	B->maxTime = 0;
+	B->flushing = 0;
+	B->late = 0;
+
+	return B;
+}
+
+void reorder_destroy(reorder* B) {
+	pool_destroy(B->entries);
+	free(B->heap);
+	free(B);
+}
+
+// the watermark: every event older than this is late
+static unsigned long int watermark(reorder* B) {
+	return (B->maxTime > B->lateness) ? B->maxTime - B->lateness : 0;
+}
+
+// 1 if entry a comes out before entry b
+static int before(entry_t* a, entry_t* b) {
+	return a->time < b->time || (a->time == b->time && a->seq < b->seq);
+}
+
+// give back the entry of the last pop
+static void release(reorder* B) {
+	if (B->popped != NULL) {
+		pool_free(B->entries, B->popped);
+		B->popped = NULL;
+	}
+}
+
+int reorder_push(reorder* B, venmoEvent* ev, unsigned long int seq) {
+
+	entry_t* e;
+	int i, parent;
+
+	release(B);
+
+	if (ev->time < watermark(B)) {
+		B->late++;
+		return 0;
+	}
+	if (ev->time > B->maxTime)
+		B->maxTime = ev->time;
+
+	e = (entry_t*)pool_alloc(B->entries);
+	e->time = ev->time;
+	e->seq = seq;
+	e->actorLen = ev->actor.len;
+	e->targetLen = ev->target.len;
+	memcpy(e->actor, ev->actor.str, ev->actor.len);
+	memcpy(e->target, ev->target.str, ev->target.len);
+
+	if (B->count == B->capacity) {
+		B->capacity = B->capacity*2;
+		B->heap = realloc(B->heap, B->capacity*sizeof(entry_t*));
+		if (B->heap == NULL) {
+			printf("\n\nFATAL ERROR: cannot expand the reorder buffer\n\n");
+			abort();
+		}
+	}
+
+	// sift the new entry up from the bottom of the heap
+	i = B->count;
+	B->count++;
+	while (i > 0) {
+		parent = (i - 1)/2;
+		if (!before(e, B->heap[parent]))
+			break;
+		B->heap[i] = B->heap[parent];
+		i = parent;
+	}
+	B->heap[i] = e;
+
+	return 1;
+}
+
+int reorder_pop(reorder* B, venmoEvent* ev, unsigned long int* seq) {
+
+	entry_t* e;
+	entry_t* last;
+	int i, child;
+
+	release(B);
+
+	// An event at the watermark can go: any event that arrives later with
+	// the same time stamp has a larger sequence number, and any earlier one
+	// is late.
+	if (B->count == 0)
+		return 0;
+	e = B->heap[0];
+	if (!B->flushing && e->time > watermark(B))
+		return 0;
+
+	// move the last entry to the top and sift it down
+	B->count--;
+	last = B->heap[B->count];
+	i = 0;
+	while (2*i + 1 < B->count) {
+		child = 2*i + 1;
+		if (child + 1 < B->count && before(B->heap[child + 1], B->heap[child]))
+			child++;
+		if (!before(B->heap[child], last))
+			break;
+		B->heap[i] = B->heap[child];
+		i = child;
+	}
+	B->heap[i] = last;
+
+	B->popped = e;
+	ev->time = e->time;
+	ev->actor.str = e->actor;
+	ev->actor.len = e->actorLen;
+	ev->target.str = e->target;
+	ev->target.len = e->targetLen;
+	*seq = e->seq;
+
+	return 1;
+}
+
+void reorder_flush(reorder* B) {
+	B->flushing = 1;
+}
+
+unsigned long int reorder_late(reorder* B) {
+	return B->late;
+}
@@ -0,0 +1,39 @@
+#ifndef _reorder_h
+#define _reorder_h
+
+#include "parser.h"
+
+typedef struct reorderPrototype reorder;
+
+// The reorder buffer holds back the events that arrive out of order, and
+// lets them out sorted by time stamp.
+// The watermark trails the largest time stamp seen so far by the lateness:
+// an event waits in the buffer until the watermark has reached its time
+// stamp, since until then an event with an earlier time stamp may still
+// arrive. An event whose time stamp is already behind the watermark when it
+// arrives is late; it is not buffered, and only counted.
+// Events with the same time stamp come out in the order they went in.
+
+// create the buffer with the given lateness in seconds
+reorder* reorder_create(int lateness);
+
+// destroy the buffer, and any events still in it
+void reorder_destroy(reorder* B);
+
+// put an event into the buffer, with its sequence number in the input
+// the names are copied, so the line of the event need not stay put
+// 1 is returned if the event is buffered, 0 if it is late
+int reorder_push(reorder* B, venmoEvent* ev, unsigned long int seq);
+
+// take the next event the watermark has passed out of the buffer, with its
+// sequence number. its names are valid until the next call to the buffer.
+// 0 is returned if no event is ready
+int reorder_pop(reorder* B, venmoEvent* ev, unsigned long int* seq);
+
+// the input has ended: let every event in the buffer out
+void reorder_flush(reorder* B);
+
+// the number of late events so far
+unsigned long int reorder_late(reorder* B);
+
+#endif
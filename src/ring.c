@@ -0,0 +1,155 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <sched.h>
+#include <time.h>
+#include "ring.h"
+
+// The counters of the two sides are kept on separate cache lines, so that
+// the producer publishing a record does not steal the line the consumer is
+// working on, and vice versa.
+#define CACHE_LINE 64
+
+// A waiting side spins SPIN_LIMIT times, then yields the processor until
+// YIELD_LIMIT, and then naps for NAP_NSEC nanoseconds at a time.
+#define SPIN_LIMIT 256
+#define YIELD_LIMIT 512
+#define NAP_NSEC 20000
+
+struct ringPrototype {
+
+	char* records;
+	int recordSize;
+	unsigned long int mask;		// capacity - 1
+
+	char pad0[CACHE_LINE];
+
+	// The producer's line.
+	// head counts the records published so far. It is only written by the
+	// producer, with release semantics, so a consumer that reads it (with
+	// acquire semantics) also sees the contents of the records.
+	// tailSeen is the producer's last look at the consumer's counter; it is
+	// enough to decide whether there is room most of the time.
+	unsigned long int head;
+	unsigned long int tailSeen;
+	int closed;
+
+	char pad1[CACHE_LINE];
+
+	// The consumer's line, the mirror image of the producer's.
+	unsigned long int tail;
+	unsigned long int headSeen;
+
+	char pad2[CACHE_LINE];
+};
+
+ring* ring_create(int recordSize, int capacity) {
+
+	assert(recordSize > 0);
+	assert(capacity > 0 && (capacity & (capacity - 1)) == 0);
+
+	ring* R = malloc(sizeof(ring));
+	assert(R != NULL);
+
+	R->records = malloc((size_t)recordSize * capacity);
+	assert(R->records != NULL);
+
+	R->recordSize = recordSize;
+	R->mask = capacity - 1;
+	R->head = 0;
+	R->tailSeen = 0;
+	R->closed = 0;
+	R->tail = 0;
+	R->headSeen = 0;
+
+	return R;
+}
+
+void ring_destroy(ring* R) {
+	free(R->records);
+	free(R);
+}
+
+// wait a little longer every time a side finds nothing to do
+static void backoff(int* spins) {
+
+	struct timespec nap = {0, NAP_NSEC};
+
+	if (*spins < SPIN_LIMIT) {
+#if defined(__x86_64__) || defined(__i386__)
+		__builtin_ia32_pause();
+#endif
+	}
+	else if (*spins < YIELD_LIMIT)
+		sched_yield();
+	else
+		nanosleep(&nap, NULL);
+
+	if (*spins < YIELD_LIMIT)
+		(*spins)++;
+}
+
+void* ring_claim(ring* R) {
+
+	int spins = 0;
+
+	// The ring is full when the producer is a whole lap ahead of the
+	// consumer. Only then is the consumer's counter read again.
+	while (R->head - R->tailSeen > R->mask) {
+		R->tailSeen = __atomic_load_n(&R->tail, __ATOMIC_ACQUIRE);
+		if (R->head - R->tailSeen > R->mask)
+			backoff(&spins);
+	}
+
+	return R->records + (R->head & R->mask) * R->recordSize;
+}
+
+void ring_publish(ring* R) {
+	__atomic_store_n(&R->head, R->head + 1, __ATOMIC_RELEASE);
+}
+
+void ring_close(ring* R) {
+	__atomic_store_n(&R->closed, 1, __ATOMIC_RELEASE);
+}
+
+void* ring_peek(ring* R) {
+
+	int spins = 0;
+
+	while (R->tail == R->headSeen) {
+		R->headSeen = __atomic_load_n(&R->head, __ATOMIC_ACQUIRE);
+		if (R->tail != R->headSeen)
+			break;
+
+		// The records published before the ring was closed must still
+		// be taken out, so the counter is read once more after the flag.
+		if (__atomic_load_n(&R->closed, __ATOMIC_ACQUIRE)) {
+			R->headSeen = __atomic_load_n(&R->head, __ATOMIC_ACQUIRE);
+			if (R->tail == R->headSeen)
+				return NULL;
+			break;
+		}
+		backoff(&spins);
+	}
+
+	return R->records + (R->tail & R->mask) * R->recordSize;
+}
+
+void* ring_peekAhead(ring* R, int k) {
+
+	// Only the counter of the producer is read again, and only if the
+	// record is not known to be there yet.
+	if (R->headSeen - R->tail <= (unsigned long int)k) {
+		R->headSeen = __atomic_load_n(&R->head, __ATOMIC_ACQUIRE);
+		if (R->headSeen - R->tail <= (unsigned long int)k)
+			return NULL;
+	}
+
+	return R->records + ((R->tail + k) & R->mask) * R->recordSize;
+}
+
+void ring_release(ring* R) {
+	__atomic_store_n(&R->tail, R->tail + 1, __ATOMIC_RELEASE);
+}
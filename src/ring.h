@@ -0,0 +1,40 @@
+#ifndef _ring_h
+#define _ring_h
+
+typedef struct ringPrototype ring;
+
+// A ring is a queue of records of a fixed size between two threads.
+// Exactly one thread (the producer) puts records in, and exactly one thread
+// (the consumer) takes them out, in the same order. No locks are taken:
+// each side owns one counter and only reads the counter of the other.
+// A side that finds the ring full (or empty) spins for a moment, then
+// yields, and finally naps until the other side catches up.
+
+// create the ring by specifying the size of a record and the number of
+// records it holds, which must be a power of two
+ring* ring_create(int recordSize, int capacity);
+
+// destroy the ring, once both threads are done with it
+void ring_destroy(ring* R);
+
+// Producer side.
+// Wait for a free record and return its address. Fill it in, then publish
+// it; the consumer does not see the record before that.
+void* ring_claim(ring* R);
+void ring_publish(ring* R);
+
+// no more records will be published
+void ring_close(ring* R);
+
+// Consumer side.
+// Wait for the next record and return its address, or NULL if the ring was
+// closed and every record has been taken out. Release the record when it is
+// no longer needed, so that the producer can reuse it.
+void* ring_peek(ring* R);
+void ring_release(ring* R);
+
+// the record k places after the next one, without waiting, or NULL if it has
+// not been published yet. like the next one, it stays put until released
+void* ring_peekAhead(ring* R, int k);
+
+#endif
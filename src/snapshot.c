@@ -0,0 +1,323 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include "snapshot.h"
+#include "expiry.h"
+
+// The layout of a snapshot:
+//   | header | nodes | branches |
+// The nodes are listed by id, from 0 to numIds-1, each as the length of its
+// name (4 bytes) followed by the name, not terminated. An id that is not in
+// use has length 0. The nodes are padded to a multiple of 8 bytes, so the
+// branches can be read straight out of the mapping.
+
+#define SNAPSHOT_MAGIC "VENSNAP1"
+
+// the buffer of the writer. it is on the stack, since the child of a fork
+// should not call malloc (another thread may have held its lock at the fork)
+#define SNAPSHOT_BUFFER 65536
+
+typedef struct {
+	char magic[8];
+	uint64_t maxTime;
+	int64_t inputOffset;
+	uint64_t lines;
+	uint64_t entryCounter;
+	uint64_t numWindows;
+	uint64_t ages[MAX_WINDOWS];
+	uint64_t numIds;
+	uint64_t nodesSize;		// including the padding
+	uint64_t numBranches;
+	uint64_t size;			// of the whole snapshot
+} snapshotHeader;
+
+typedef struct {
+	int fd;
+	int failed;
+	size_t pos;
+	char buf[SNAPSHOT_BUFFER];
+} snapshotOut;
+
+static void drain(snapshotOut* O) {
+
+	size_t done = 0;
+	ssize_t n;
+
+	while (done < O->pos && !O->failed) {
+		n = write(O->fd, O->buf + done, O->pos - done);
+		if (n <= 0)
+			O->failed = 1;
+		else
+			done = done + n;
+	}
+	O->pos = 0;
+}
+
+static void put(snapshotOut* O, const void* data, size_t len) {
+
+	size_t n;
+
+	while (len > 0) {
+		if (O->pos == SNAPSHOT_BUFFER)
+			drain(O);
+		n = (len < SNAPSHOT_BUFFER - O->pos) ? len : SNAPSHOT_BUFFER - O->pos;
+		memcpy(O->buf + O->pos, data, n);
+		O->pos = O->pos + n;
+		data = (const char*)data + n;
+		len = len - n;
+	}
+}
+
+int snapshot_write(char* path, snapshotInfo* info, intern* I, List* L) {
+
+	snapshotHeader H;
+	snapshotBranch B;
+	snapshotOut O;
+	char tmpPath[4096];
+	uint64_t zero = 0;
+	uint32_t id, len;
+	char* name;
+	void* block;
+	int j;
+
+	if (strlen(path) + 5 > sizeof(tmpPath))
+		return 0;
+	strcpy(tmpPath, path);
+	strcat(tmpPath, ".tmp");
+
+	// the sizes of the nodes and the branches go into the header first
+	memset(&H, 0, sizeof(snapshotHeader));
+	memcpy(H.magic, SNAPSHOT_MAGIC, 8);
+	H.maxTime = info->maxTime;
+	H.inputOffset = info->inputOffset;
+	H.lines = info->lines;
+	H.entryCounter = info->entryCounter;
+	H.numWindows = info->numWindows;
+	for (j=0; j<info->numWindows; j++)
+		H.ages[j] = info->ages[j];
+	H.numIds = intern_capacity(I);
+
+	for (id=0; id<H.numIds; id++) {
+		name = intern_getName(I, id);
+		H.nodesSize = H.nodesSize + sizeof(uint32_t) + (name == NULL ? 0 : strlen(name));
+		if (name != NULL)
+			H.numBranches = H.numBranches + List_lenRec(L, id);
+	}
+	H.nodesSize = (H.nodesSize + 7) & ~(uint64_t)7;
+	H.size = sizeof(snapshotHeader) + H.nodesSize + H.numBranches*sizeof(snapshotBranch);
+
+	O.fd = open(tmpPath, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+	if (O.fd < 0)
+		return 0;
+	O.failed = 0;
+	O.pos = 0;
+
+	put(&O, &H, sizeof(snapshotHeader));
+
+	for (id=0; id<H.numIds; id++) {
+		name = intern_getName(I, id);
+		len = (name == NULL ? 0 : strlen(name));
+		put(&O, &len, sizeof(uint32_t));
+		put(&O, name, len);
+	}
+	put(&O, &zero, (8 - (O.pos & 7)) & 7);
+
+	for (id=0; id<H.numIds; id++) {
+		if (intern_getName(I, id) == NULL)
+			continue;
+		block = List_firstBlock(L, id);
+		for (j=0; j<List_lenRec(L, id); j++) {
+			B.time = expiry_getTime(List_getDatum(block));
+			B.owner = id;
+			B.name = List_getName(block);
+			put(&O, &B, sizeof(snapshotBranch));
+			block = List_nextBlock(block);
+		}
+	}
+
+	drain(&O);
+	if (close(O.fd) != 0)
+		O.failed = 1;
+
+	// the snapshot only takes the place of the last one once it is whole
+	if (O.failed || rename(tmpPath, path) != 0) {
+		unlink(tmpPath);
+		return 0;
+	}
+	return 1;
+}
+
+pid_t snapshot_fork(char* path, snapshotInfo* info, intern* I, List* L) {
+
+	pid_t child = fork();
+
+	if (child == 0)
+		_exit(snapshot_write(path, info, I, L) ? 0 : 1);
+	return child;
+}
+
+int snapshot_done(pid_t child, int wait) {
+
+	int status;
+
+	return waitpid(child, &status, wait ? 0 : WNOHANG) != 0;
+}
+
+struct snapshotPrototype {
+	int fd;
+	char* data;
+	size_t size;
+	int valid;
+
+	snapshotHeader* H;
+	snapshotInfo info;
+
+	// the next node of the iteration
+	char* next;
+	uint32_t nextId;
+
+	snapshotBranch* branches;
+};
+
+// check that the parts of the snapshot add up
+static int checkSnapshot(snapshot* S) {
+
+	snapshotHeader* H = S->H;
+	char* pos = S->data + sizeof(snapshotHeader);
+	char* end = pos + H->nodesSize;
+	unsigned char* inUse;
+	uint32_t len, id;
+	uint64_t b;
+
+	if (S->size < sizeof(snapshotHeader) || memcmp(H->magic, SNAPSHOT_MAGIC, 8) != 0
+		|| H->size != S->size || H->numWindows < 1 || H->numWindows > MAX_WINDOWS
+		|| H->numIds >= INTERN_NONE || H->nodesSize % 8 != 0 || H->numIds*sizeof(uint32_t) > H->nodesSize
+		|| H->size != sizeof(snapshotHeader) + H->nodesSize + H->numBranches*sizeof(snapshotBranch))
+		return 0;
+
+	inUse = calloc(H->numIds + 1, 1);
+	assert(inUse != NULL);
+
+	for (id=0; id<H->numIds; id++) {
+		if (end - pos < (long)sizeof(uint32_t))
+			break;
+		memcpy(&len, pos, sizeof(uint32_t));
+		pos = pos + sizeof(uint32_t);
+		if (len >= MAX_STR_LEN || end - pos < (long)len)
+			break;
+		inUse[id] = (len > 0);
+		pos = pos + len;
+	}
+
+	for (b=0; id == H->numIds && b < H->numBranches; b++) {
+		if (S->branches[b].owner >= H->numIds || S->branches[b].name >= H->numIds
+			|| !inUse[S->branches[b].owner] || !inUse[S->branches[b].name])
+			break;
+	}
+
+	free(inUse);
+	return (id == H->numIds && b == H->numBranches);
+}
+
+snapshot* snapshot_open(char* path) {
+
+	struct stat st;
+	int j;
+
+	int fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return NULL;
+
+	snapshot* S = malloc(sizeof(snapshot));
+	assert(S != NULL);
+
+	S->fd = fd;
+	S->data = NULL;
+	S->size = 0;
+	S->valid = 0;
+
+	if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || (size_t)st.st_size < sizeof(snapshotHeader))
+		return S;
+
+	S->data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (S->data == MAP_FAILED) {
+		S->data = NULL;
+		return S;
+	}
+	S->size = st.st_size;
+
+	S->H = (snapshotHeader*)S->data;
+	S->branches = (snapshotBranch*)(S->data + sizeof(snapshotHeader) + S->H->nodesSize);
+	if (!checkSnapshot(S))
+		return S;
+
+	S->valid = 1;
+	S->info.maxTime = S->H->maxTime;
+	S->info.inputOffset = S->H->inputOffset;
+	S->info.lines = S->H->lines;
+	S->info.entryCounter = S->H->entryCounter;
+	S->info.numWindows = S->H->numWindows;
+	for (j=0; j<S->info.numWindows; j++)
+		S->info.ages[j] = S->H->ages[j];
+
+	S->next = S->data + sizeof(snapshotHeader);
+	S->nextId = 0;
+
+	return S;
+}
+
+int snapshot_valid(snapshot* S) {
+	return S->valid;
+}
+
+void snapshot_close(snapshot* S) {
+	if (S->data != NULL)
+		munmap(S->data, S->size);
+	close(S->fd);
+	free(S);
+}
+
+snapshotInfo* snapshot_info(snapshot* S) {
+	return &S->info;
+}
+
+uint32_t snapshot_numIds(snapshot* S) {
+	return S->H->numIds;
+}
+
+int snapshot_nextNode(snapshot* S, uint32_t* id, nameView* name) {
+
+	uint32_t len;
+
+	while (S->nextId < S->H->numIds) {
+		memcpy(&len, S->next, sizeof(uint32_t));
+		S->next = S->next + sizeof(uint32_t);
+		S->nextId++;
+		if (len == 0)
+			continue;
+
+		*id = S->nextId - 1;
+		name->str = S->next;
+		name->len = len;
+		S->next = S->next + len;
+		return 1;
+	}
+	return 0;
+}
+
+snapshotBranch* snapshot_branches(snapshot* S) {
+	return S->branches;
+}
+
+unsigned long int snapshot_numBranches(snapshot* S) {
+	return S->H->numBranches;
+}
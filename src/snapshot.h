@@ -0,0 +1,77 @@
+#ifndef _snapshot_h
+#define _snapshot_h
+
+#include <stdint.h>
+#include <sys/types.h>
+#include "intern.h"
+#include "list.h"
+#include "parser.h"
+#include "venmoGraphParams.h"
+
+// A snapshot of the graph, from which a new process resumes where the old
+// one left off, instead of reading a whole window of events again.
+// It holds the names of the nodes, every branch with its time stamp, the
+// max time and the windows, and where in the input the graph stands.
+// The degrees, and with them the histograms, follow from the branches.
+// The numbers are stored in the byte order of the machine.
+
+// what a snapshot records besides the graph
+typedef struct {
+	unsigned long int maxTime;
+	int numWindows;
+	unsigned long int ages[MAX_WINDOWS];	// the windows, in the order of the columns
+	long long int inputOffset;	// the input up to here has been applied
+	unsigned long int lines;	// the lines of the output up to there
+	int entryCounter;			// the events that entered the graph
+} snapshotInfo;
+
+// A branch of the graph. The owner is the node whose list records it, and
+// the name is the node at the other end, both by their ids in the snapshot.
+typedef struct {
+	uint64_t time;
+	uint32_t owner;
+	uint32_t name;
+} snapshotBranch;
+
+// Write a snapshot of the graph to the file at path, in a child process, so
+// the caller goes on with the next event at once. The child sees the graph
+// as it was at the fork, however the caller changes it later. The file is
+// written under another name and renamed when it is complete, so a crash
+// never leaves half a snapshot behind.
+// The id of the child is returned, or -1 if it could not be started.
+pid_t snapshot_fork(char* path, snapshotInfo* info, intern* I, List* L);
+
+// 1 if the snapshot of the child is done (or failed), 0 if it is still
+// being written. With wait set, wait for it to be done
+int snapshot_done(pid_t child, int wait);
+
+// write a snapshot in this process
+// 1 is returned if it was written, 0 otherwise
+int snapshot_write(char* path, snapshotInfo* info, intern* I, List* L);
+
+typedef struct snapshotPrototype snapshot;
+
+// open the snapshot at path, which is memory-mapped in one piece
+// NULL is returned if there is no such file, and the file is flagged as
+// not valid (see snapshot_valid) if it is not a whole snapshot
+snapshot* snapshot_open(char* path);
+int snapshot_valid(snapshot* S);
+
+// unmap and close the snapshot
+void snapshot_close(snapshot* S);
+
+// what the snapshot records besides the graph
+snapshotInfo* snapshot_info(snapshot* S);
+
+// one more than the largest id of a node in the snapshot
+uint32_t snapshot_numIds(snapshot* S);
+
+// iterate through the nodes: fill in the id and the name of the next one,
+// 0 is returned after the last. the name stays valid until the snapshot is closed
+int snapshot_nextNode(snapshot* S, uint32_t* id, nameView* name);
+
+// the branches, and their number. every id in them is that of a node
+snapshotBranch* snapshot_branches(snapshot* S);
+unsigned long int snapshot_numBranches(snapshot* S);
+
+#endif
@@ -1,329 +1,538 @@
-#include <stdio.h>
-#include <stdlib.h>
-#include <signal.h>
-#include <string.h>
-#include <assert.h>
-#include "table.h"
-#include "venmoGraphParams.h"
-
-#define MAX_LOAD 0.75
-
-struct tablePrototype {
-
-    void** cells;
-
-	int count_cells;
-	int count_elems;
-	int dataSize;
-	
-    float load;
-
-	int (*hashFunc)(char* key, int n); // pointer to the hash function
-
-    dataCleanFn dataDeleter;
-};
-
-static int hash(char* s, int nCells) {
-	unsigned long MULTIPLIER = 2630849305L;
-	unsigned long hashcode = 0;
-	for (int i=0; s[i] != '\0'; i++)
-		hashcode = hashcode * MULTIPLIER + s[i];
-	return hashcode % nCells;
-}
-
-table* table_create(int dataSize, int initCapacity,  dataCleanFn fn) {
-
-	table* T = malloc(sizeof(table));
-
-    // Check that memory for the map is available
-    assert(T != NULL);
-
-	T->count_cells = initCapacity;
-	
-	T->count_elems = 0;
-	T->dataSize = dataSize;
-    T->load = 0;
-
-    T->cells = calloc(T->count_cells, sizeof(void*));
-
-    // Check that memory for the cells could be allocated
-    assert(T->cells != NULL);
-        
-	// set the hash function and any value cleanup function
-	T->hashFunc = hash;
-    T->dataDeleter = fn;
-	
-	return T;
-}
-
-// deallocate the cmap
-void table_destroy(table* T) {
-
-    int i;
-    void* aCell;
-    void* bCell;
-    char* tempKey;
-    void* datum;
-
-	// Since each cell potentially contains an entire list of other cells,
-	// each of which had to be allocated on the heap, we must iterate 
-	// through all the entries and free the keys. if the value was also 
-	// allocated on the heap by the user, the cleanup function is called
-    for (i=0; i<T->count_cells; ++i) {
-        aCell = T->cells[i];
-        bCell = aCell;
-        while (bCell != NULL) {
-            aCell = *(void**)bCell;
-            if (T->dataDeleter != NULL) {
-                tempKey = (char*)bCell + sizeof(void*);
-                datum = (char*)bCell + sizeof(void*) + strlen(tempKey) + 1;
-                T->dataDeleter(datum);
-            }
-            free(bCell);
-            bCell = aCell;
-        }
-    }
-
-	// Every malloc needs a free
-    free(T->cells);
-    free(T);
-}
-
-// Return the number of elements
-int table_count(table* T) {
-    return T->count_elems;
-}
-
-// Rehash gets called from cmap_put if the load of the CMap exceeds the MAX_LOAD
-void table_rehash(table* T) {
-
-    int old_count = T->count_cells;
-    T->count_cells = T->count_cells*2 + 1;
-
-    void** new_cell_array = realloc(T->cells, (T->count_cells)*sizeof(void*));
-
-    // If the reallocation cannot be performed, return, and the rehash is not performed. 
-    if (new_cell_array == NULL) {
-        printf("\n\n Table rehashing failed\n\n");
-		return;
-	}
-
-    void* aCell;
-    void* bCell;
-    void* nCell;
-
-    int h, i;
-    char* key;
-
-    // Initialize the new cells
-    for (i=old_count; i<T->count_cells; ++i)
-        new_cell_array[i] = NULL;
-
-    // Rehash the old cells
-    for (i=0; i<old_count; ++i) {
-        aCell = &new_cell_array[i];
-        nCell =  new_cell_array[i];
-        while (nCell != NULL) {
-
-            key = (char*)nCell + sizeof(void*);
-            h = T->hashFunc(key, T->count_cells);
-
-            // If the hash (h) is not the correct root cell (i), we have to move
-            // the cell.
-            if (h != i) {
-
-                bCell = *(void**)nCell;     // retain in b whatever n points to
-
-                // link nCell into its new slot in the array, and make sure that
-                // it points to whatever is already in the array
-                *(void**)nCell = new_cell_array[h];
-                new_cell_array[h] = nCell;
-
-                // reset nCell to the next element in the list
-                nCell = bCell;
-
-                // change the actual address of the previous cell to reflect the
-                // fact that its contents have been moved
-                *(void**)aCell = bCell;
-            }
-            else {
-                nCell = *(void**)nCell; // just move right down the list
-                aCell = *(void**)aCell;
-            }
-        }
-    }
-    T->cells = new_cell_array;
-}
-
-int table_checkLoad(table* T) {
-	T->load = ((float)T->count_elems)/((float)T->count_cells);
-	if ((float)(T->load) > MAX_LOAD) {
-		table_rehash(T);
-		return 1;
-	}
-	return 0;
-}
-
-// add a new element to the map. if the key already exists, the old value
-// is cleared by the cleanup function, if it exists. 
-// Note that rehashing does not raise an assert if it fails; the map is simply
-// used in its old form. HOWEVER, an assert is raised if this "put" function
-// fails to allocate memory for the new cell.
-void* table_put(table* T, char* key, void* addr) {
-
-	int hashCode = T->hashFunc(key, T->count_cells);
-
-	void* rootCell;
-	void* newCell;
-	void* nextCell;
-
-	// Check if the key exists in the map already
-	void* keyCell = table_getCell(T, key);
-
-	if (keyCell != NULL) {
-		rootCell = &keyCell; 
-		newCell  = keyCell;
-		nextCell = *(void**)keyCell;
-	}
-	else {
-		T->count_elems = T->count_elems + 1;
-
-		rootCell = &(T->cells[hashCode]);
-		newCell  = malloc(sizeof(void**) + strlen(key) + 1 + T->dataSize);
-		nextCell =  T->cells[hashCode];
-
-        char initializer = '\0';
-        memcpy((char*)newCell + sizeof(void*), &initializer, sizeof(char));
-
-		assert(newCell != NULL);
-	}
-
-	// Ensure that the address in the new cell references the location of the
-    // next cell. Also set the root pointer to point to the new cell
-    *(void**)newCell = nextCell; 
-	*(void**)rootCell = newCell;
-    
-    // Copy the key and the value, but first check if the key already exists
-    char* keyDest = (char*)newCell + sizeof(void*);
-    void* datDest = (char*)newCell + sizeof(void*) + strlen(key) + 1;
-
-    if (strcmp(keyDest, key) == 0) {
-        if (T->dataDeleter != NULL)
-            T->dataDeleter(datDest);
-    }
-    else
-        strcpy(keyDest, key);
-
-    memcpy(datDest, addr, T->dataSize);
-	
-	return (void*)keyDest;
-}
-
-void* table_getCell(table* T, char* key) {
-
-	int hashCode = T->hashFunc(key, T->count_cells);
-
-    void* aCell = T->cells[hashCode];
-
-    // Continue through the list. If we find the key, return the position of the
-    // value. If we run through the whole list and get to the NULL at the end,
-    // we return NULL
-
-    while (aCell != NULL) {
-        if ( strcmp((char*)aCell + sizeof(void*), key) == 0 )
-            return (char*)aCell;
-        
-        aCell = *(void**)aCell;
-    }
-    return NULL;
-}
-
-void* table_getKey(void* cell) {
-	return (char*)cell + sizeof(void*);
-}
-
-void* table_getDatum(table* T, void* cell, char* key) {
-	return (char*)cell + sizeof(void*) + strlen(key) + 1;
-}
-
-// Remove an element from the map. if the key is not found, the map is unchanged
-void table_remove(table* T, char* key) {
-    
-    int hashCode = T->hashFunc(key, T->count_cells);
-    void* aCell = &T->cells[hashCode];
-    void* pCell = &T->cells[hashCode];
-
-	int keyFound = 0;
-
-	// Find the element AND the address of the previous cell. We need
-	// to be able to link the previous cell to the one following the 
-	// one we are deleting
-    while (aCell != NULL) {
-        if ( strcmp((char*)aCell + sizeof(void*), key) == 0 ) {
-			keyFound = 1;
-            break;
-		}
-
-        pCell = aCell;
-        aCell = *(void**)aCell;
-    }
- 
-	// End the function if the key could not be found
-	if (keyFound == 0)
-		return;
-
-    void* datum;
-    char* tempKey;
-    if (T->dataDeleter != NULL) {
-        tempKey = (char*)aCell + sizeof(void*);
-        datum = (char*)aCell + sizeof(void*) + strlen(tempKey) + 1;
-        T->dataDeleter(datum);
-    }
-
-    // Make sure to fully remove the key by copying a terminator into its
-    // address
-    strcpy((char*)aCell + sizeof(void*), "\0");
-
-    // Link the previous cell to the next one ...
-    *(void**)pCell = *(void**)aCell;
-
-    // ... and free the cell in between them
-    free(aCell);
-
-    // Decrement the count; don't need to compute load here
-    T->count_elems = T->count_elems - 1;
-}
-
-
-void* table_firstCell(table* T) {
-
-	if (T->count_elems == 0)
-        return NULL;
-
-    int i = 0;
-    while(T->cells[i] == NULL)
-        i = i + 1;
-
-    return (void*)T->cells[i];
-}
-
-void* table_nextCell(table* T, void* prevCell, char* key) {
-	
-    int h = T->hashFunc(key, T->count_cells);
-	void* cell = *(void**)prevCell;
-
-	if (cell == NULL) {
-        h = h + 1;
-		if (h >= T->count_cells)
-			return NULL;
-        while (T->cells[h] == NULL) {
-            h = h + 1;
-			if (h >= T->count_cells)
-				return NULL;
-		}
-        return (void*)T->cells[h];
-    }
-    else {
-        return cell;
-    }
-}
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include "table.h"
+#include "pool.h"
+#include "instrument.h"
+#include "venmoGraphParams.h"
+
+// The table grows when it is more than MAX_LOAD full, and shrinks when it
+// is less than MIN_LOAD full. After either, it is half way in between, so
+// a table that hovers around one size is not rehashed back and forth.
+#define MAX_LOAD 0.75
+#define MIN_LOAD 0.1875
+
+// A small table is never shrunk. Its slots cost next to nothing, while a
+// graph of a handful of nodes would otherwise grow and shrink it all the time.
+#define MIN_SHRINK_SLOTS 256
+
+// The size of a cell depends on the length of its key, so the cells are
+// cut out of pools of size classes that are CLASS_SIZE bytes apart.
+// A cell that is too large for every class is malloc'd.
+#define CLASS_SIZE 16
+
+// A slot of the table. An empty slot has no cell.
+// The full hash of the key is kept next to the cell, so probing compares
+// hashes before it ever touches a key, and rehashing never hashes a key again.
+typedef struct {
+	uint64_t hash;
+	void* cell;
+} slot_t;
+
+// a cell has the following structure in memory:
+//    | hash | len | datum | key |
+// the cell remembers the hash and the length of its key, so an entry is
+// found from its cell, and its cell given back, without reading the key.
+// the datum comes next, at a fixed offset, and the key last
+typedef struct {
+	uint64_t hash;
+	int len;
+} cellHead_t;
+
+#define CELL_DATUM_OFFSET sizeof(cellHead_t)
+
+// While the table is resized, the entries that are still in the old array
+// are moved MIGRATE_STEPS slots at a time, for every time the old array is
+// larger than the new one. The new array is at most 3/8 full when the resize
+// starts, so it is not full before the old array has been emptied.
+#define MIGRATE_STEPS 8
+
+// the mark left in the slot of the old array whose entry has moved
+static char movedMark;
+#define MOVED ((void*)&movedMark)
+
+struct tablePrototype {
+
+	slot_t* slots;
+
+	int count_slots;	// always a power of 2
+	int min_slots;		// the table never shrinks below this size
+	int count_elems;
+	int dataSize;
+
+	slot_t* old;		// the array being emptied by a resize, or NULL
+	int count_old;
+	int migrated;		// the slots of the old array before this are empty
+	int steps;			// the number of slots to move per operation
+
+	uint64_t (*hashFunc)(char* key, int len); // pointer to the hash function
+
+	dataCleanFn dataDeleter;
+
+	pool** pools;		// pools[c] holds the cells of up to (c+1)*CLASS_SIZE bytes
+	int count_pools;
+	int count_big;		// number of malloc'd cells
+	size_t bytes_cells;	// the bytes of the cells in use, pooled or not
+};
+
+// size in bytes of the cell of a key of length keyLen
+static int cellSize(table* T, int keyLen) {
+	return CELL_DATUM_OFFSET + T->dataSize + keyLen + 1;
+}
+
+static void* allocCell(table* T, int keyLen) {
+
+	int c = (cellSize(T, keyLen) - 1) / CLASS_SIZE;
+
+	if (c >= T->count_pools) {
+		T->count_big = T->count_big + 1;
+		T->bytes_cells = T->bytes_cells + cellSize(T, keyLen);
+		return malloc(cellSize(T, keyLen));
+	}
+	if (T->pools[c] == NULL)
+		T->pools[c] = pool_create((c+1)*CLASS_SIZE);
+	T->bytes_cells = T->bytes_cells + (c+1)*CLASS_SIZE;
+
+	return pool_alloc(T->pools[c]);
+}
+
+// give a cell back
+static void releaseCell(table* T, void* cell) {
+
+	int c = (cellSize(T, ((cellHead_t*)cell)->len) - 1) / CLASS_SIZE;
+
+	if (c >= T->count_pools) {
+		T->count_big = T->count_big - 1;
+		T->bytes_cells = T->bytes_cells - cellSize(T, ((cellHead_t*)cell)->len);
+		free(cell);
+	}
+	else {
+		T->bytes_cells = T->bytes_cells - (c+1)*CLASS_SIZE;
+		pool_free(T->pools[c], cell);
+	}
+}
+
+// The hash reads the key 8 bytes at a time and mixes the bits at the end,
+// so that the low bits, which pick the slot, depend on the whole key.
+static uint64_t hash(char* s, int len) {
+
+	const uint64_t MULTIPLIER = 0x9E3779B97F4A7C15ULL;
+	uint64_t hashcode = (uint64_t)len * MULTIPLIER;
+	uint64_t word;
+
+	while (len >= 8) {
+		memcpy(&word, s, 8);
+		hashcode = (hashcode ^ word) * MULTIPLIER;
+		hashcode = hashcode ^ (hashcode >> 32);
+		s = s + 8;
+		len = len - 8;
+	}
+	word = 0;
+	memcpy(&word, s, len);
+	hashcode = (hashcode ^ word) * MULTIPLIER;
+
+	hashcode = hashcode ^ (hashcode >> 33);
+	hashcode = hashcode * 0xFF51AFD7ED558CCDULL;
+	hashcode = hashcode ^ (hashcode >> 33);
+	hashcode = hashcode * 0xC4CEB9FE1A85EC53ULL;
+	hashcode = hashcode ^ (hashcode >> 33);
+	return hashcode;
+}
+
+uint64_t table_hash(char* key, int len) {
+	return hash(key, len);
+}
+
+table* table_create(int dataSize, int initCapacity,  dataCleanFn fn) {
+
+	table* T = malloc(sizeof(table));
+
+	// Check that memory for the map is available
+	assert(T != NULL);
+
+	// the number of slots is a power of 2, so the slot of a hash is its low bits
+	T->count_slots = 1;
+	while (T->count_slots < initCapacity)
+		T->count_slots = T->count_slots*2;
+	T->min_slots = T->count_slots;
+	if (T->min_slots < MIN_SHRINK_SLOTS)
+		T->min_slots = MIN_SHRINK_SLOTS;
+
+	T->count_elems = 0;
+	T->dataSize = dataSize;
+
+	T->slots = calloc(T->count_slots, sizeof(slot_t));
+	T->old = NULL;
+	T->count_old = 0;
+	T->migrated = 0;
+
+	// Check that memory for the slots could be allocated
+	assert(T->slots != NULL);
+
+	// set the hash function and any value cleanup function
+	T->hashFunc = hash;
+	T->dataDeleter = fn;
+
+	// there is a size class for every key of up to MAX_STR_LEN characters
+	T->count_pools = (CELL_DATUM_OFFSET + MAX_STR_LEN + 1 + dataSize - 1) / CLASS_SIZE + 1;
+	T->pools = calloc(T->count_pools, sizeof(pool*));
+	assert(T->pools != NULL);
+	T->count_big = 0;
+	T->bytes_cells = 0;
+
+	return T;
+}
+
+// deallocate the table
+void table_destroy(table* T) {
+
+	int i;
+	void* cell;
+	tableIterator it;
+
+	// The cells come from pools that are released all at once, so we only
+	// go through the slots if the value was also allocated on the heap by
+	// the user, to call the cleanup function, or if some cells were too
+	// large for the pools.
+	if (T->dataDeleter != NULL || T->count_big > 0) {
+		table_iterate(T, &it);
+		while ((cell = table_nextCell(&it)) != NULL) {
+			if (T->dataDeleter != NULL)
+				T->dataDeleter(table_getDatum(cell));
+			if ((cellSize(T, ((cellHead_t*)cell)->len) - 1) / CLASS_SIZE >= T->count_pools)
+				free(cell);
+		}
+	}
+
+	for (i=0; i<T->count_pools; ++i) {
+		if (T->pools[i] != NULL)
+			pool_destroy(T->pools[i]);
+	}
+
+	// Every malloc needs a free
+	free(T->pools);
+	free(T->slots);
+	free(T->old);
+	free(T);
+}
+
+// Return the number of elements
+int table_count(table* T) {
+	return T->count_elems;
+}
+
+size_t table_bytes(table* T) {
+	return sizeof(table) + T->count_pools*sizeof(pool*)
+		+ ((size_t)T->count_slots + T->count_old)*sizeof(slot_t) + T->bytes_cells;
+}
+
+// how far the entry in slot i of an array of count slots is from the slot
+// its hash points to
+static uint32_t probeDistance(slot_t* slots, int count, uint32_t i) {
+	uint32_t mask = count - 1;
+	return (i - (uint32_t)(slots[i].hash & mask)) & mask;
+}
+
+// put a cell in a slot of the current array, in Robin Hood order
+static void placeSlot(table* T, uint64_t hashCode, void* cell) {
+
+	// Robin Hood hashing: walk from the slot of the hash, and whenever the
+	// entry in a slot is closer to its own slot than we are to ours, take
+	// its place and carry on placing it instead. The distances stay short
+	// and even, and a search can stop as soon as it meets an entry that is
+	// closer to home than the key it is looking for would be.
+
+	uint32_t mask = T->count_slots - 1;
+	uint32_t i = hashCode & mask;
+	uint32_t dist = 0;
+	uint32_t d;
+	slot_t cur, tmp;
+
+	cur.hash = hashCode;
+	cur.cell = cell;
+
+	for (;;) {
+		if (T->slots[i].cell == NULL) {
+			T->slots[i] = cur;
+			return;
+		}
+		d = probeDistance(T->slots, T->count_slots, i);
+		if (d < dist) {
+			tmp = T->slots[i];
+			T->slots[i] = cur;
+			cur = tmp;
+			dist = d;
+		}
+		i = (i + 1) & mask;
+		dist++;
+	}
+}
+
+// move the entries of up to "steps" slots of the old array to the current one
+static void migrate(table* T, int steps) {
+
+	// A moved entry leaves its hash behind in the old array, with the MOVED
+	// mark instead of its cell. So the distances of the entries still in the
+	// old array do not change, and they are found there exactly as before.
+
+	slot_t* s;
+
+	while (steps > 0 && T->migrated < T->count_old) {
+		s = &T->old[T->migrated];
+		if (s->cell != NULL && s->cell != MOVED) {
+			placeSlot(T, s->hash, s->cell);
+			s->cell = MOVED;
+		}
+		T->migrated = T->migrated + 1;
+		steps = steps - 1;
+	}
+
+	if (T->migrated == T->count_old) {
+		free(T->old);
+		T->old = NULL;
+		T->count_old = 0;
+	}
+}
+
+// start moving all the entries to a new array of newCount slots
+static void rehash(table* T, int newCount) {
+
+	INSTR_START(t);
+	slot_t* newSlots = calloc(newCount, sizeof(slot_t));
+
+	// If the allocation fails, the table is simply used in its old form
+	if (newSlots == NULL) {
+		printf("\n\n Table rehashing failed\n\n");
+		return;
+	}
+
+	// The current array becomes the old one, and the entries move over a
+	// few at a time, with every put and remove, so that no single operation
+	// pays for moving the whole table.
+	// the hashes are stored, so no key is hashed again
+	T->old = T->slots;
+	T->count_old = T->count_slots;
+	T->migrated = 0;
+
+	T->slots = newSlots;
+	T->count_slots = newCount;
+
+	T->steps = MIGRATE_STEPS;
+	if (T->count_old > newCount)
+		T->steps = MIGRATE_STEPS * (T->count_old / newCount);
+
+	if (!INCREMENTAL_REHASH)
+		migrate(T, T->count_old);
+	
+	INSTR_STOP(STAGE_REHASH, t);
+	INSTR_COUNT(COUNT_REHASHES, 1);
+}
+
+int table_checkLoad(table* T) {
+
+	int newCount = T->count_slots;
+
+	// The new array is large enough to hold every entry before the old one
+	// has been emptied, unless the migration was starved. In that case it
+	// is finished at once, before the table is resized again.
+	if (T->old != NULL) {
+		if (T->count_elems <= MAX_LOAD*T->count_slots)
+			return 0;
+		migrate(T, T->count_old);
+	}
+
+	while (T->count_elems > MAX_LOAD*newCount)
+		newCount = newCount*2;
+	while (newCount > T->min_slots && T->count_elems < MIN_LOAD*newCount)
+		newCount = newCount/2;
+
+	if (newCount == T->count_slots)
+		return 0;
+
+	rehash(T, newCount);
+	return 1;
+}
+
+// find the slot of a key in an array of count slots, or -1 if it is not there
+static int findSlot(slot_t* slots, int count, int dataSize, uint64_t hashCode, char* key, int keyLen) {
+
+	uint32_t mask = count - 1;
+	uint32_t i = hashCode & mask;
+	uint32_t dist = 0;
+	void* cell;
+
+	// stop at an empty slot, or at an entry closer to its slot than the
+	// key would be; Robin Hood order means the key cannot be further on
+	while (slots[i].cell != NULL && probeDistance(slots, count, i) >= dist) {
+		cell = slots[i].cell;
+		if (slots[i].hash == hashCode && cell != MOVED && ((cellHead_t*)cell)->len == keyLen) {
+			if ( memcmp((char*)cell + CELL_DATUM_OFFSET + dataSize, key, keyLen) == 0 )
+				return i;
+		}
+		i = (i + 1) & mask;
+		dist++;
+	}
+	return -1;
+}
+
+// find the slot that holds a cell in an array of count slots, or -1
+static int findSlotOfCell(slot_t* slots, int count, void* cell) {
+
+	uint64_t hashCode = ((cellHead_t*)cell)->hash;
+	uint32_t mask = count - 1;
+	uint32_t i = hashCode & mask;
+	uint32_t dist = 0;
+
+	while (slots[i].cell != NULL && probeDistance(slots, count, i) >= dist) {
+		if (slots[i].cell == cell)
+			return i;
+		i = (i + 1) & mask;
+		dist++;
+	}
+	return -1;
+}
+
+// find the cell of a key in the current array, and then in the old one
+static void* findCell(table* T, uint64_t hashCode, char* key, int keyLen) {
+
+	int i = findSlot(T->slots, T->count_slots, T->dataSize, hashCode, key, keyLen);
+	if (i >= 0)
+		return T->slots[i].cell;
+
+	if (T->old != NULL) {
+		i = findSlot(T->old, T->count_old, T->dataSize, hashCode, key, keyLen);
+		if (i >= 0)
+			return T->old[i].cell;
+	}
+	return NULL;
+}
+
+// add a new element to the table. if the key already exists, the old value
+// is cleared by the cleanup function, if it exists, and replaced.
+// An assert is raised if this "put" function fails to allocate memory for
+// the new cell.
+void* table_put(table* T, char* key, int keyLen, void* addr) {
+
+	uint64_t hashCode = T->hashFunc(key, keyLen);
+	void* cell;
+	char* keyDest;
+
+	if (T->old != NULL)
+		migrate(T, T->steps);
+
+	// Check if the key exists in the table already
+	cell = findCell(T, hashCode, key, keyLen);
+
+	if (cell != NULL) {
+		if (T->dataDeleter != NULL)
+			T->dataDeleter(table_getDatum(cell));
+	}
+	else {
+		cell = allocCell(T, keyLen);
+		assert(cell != NULL);
+
+		((cellHead_t*)cell)->hash = hashCode;
+		((cellHead_t*)cell)->len = keyLen;
+
+		// Copy the key and terminate it, as it need not be terminated
+		// where it comes from
+		keyDest = table_getKey(T, cell);
+		memcpy(keyDest, key, keyLen);
+		keyDest[keyLen] = '\0';
+
+		// make room first, so there is always an empty slot to stop at
+		// new entries always go into the current array
+		T->count_elems = T->count_elems + 1;
+		table_checkLoad(T);
+
+		placeSlot(T, hashCode, cell);
+	}
+
+	memcpy(table_getDatum(cell), addr, T->dataSize);
+
+	return cell;
+}
+
+void* table_getCell(table* T, char* key, int keyLen) {
+	return findCell(T, T->hashFunc(key, keyLen), key, keyLen);
+}
+
+char* table_getKey(table* T, void* cell) {
+	return (char*)cell + CELL_DATUM_OFFSET + T->dataSize;
+}
+
+int table_getKeyLen(void* cell) {
+	return ((cellHead_t*)cell)->len;
+}
+
+void* table_getDatum(void* cell) {
+	return (char*)cell + CELL_DATUM_OFFSET;
+}
+
+// Remove the entry of a cell from the table
+void table_remove(table* T, void* cell) {
+
+	uint32_t mask = T->count_slots - 1;
+	int i, j;
+
+	if (T->old != NULL)
+		migrate(T, T->steps);
+
+	i = findSlotOfCell(T->slots, T->count_slots, cell);
+
+	// An entry that is still in the old array is only marked as moved
+	// there, so the entries after it keep their places until they move.
+	if (i < 0) {
+		i = findSlotOfCell(T->old, T->count_old, cell);
+		T->old[i].cell = MOVED;
+	}
+	else {
+		// Backward shift: pull the following entries one slot back, until one
+		// of them is already in its own slot. No slot is marked as deleted, so
+		// the searches stay as short as if the entry had never been there.
+		for (;;) {
+			j = (i + 1) & mask;
+			if (T->slots[j].cell == NULL || probeDistance(T->slots, T->count_slots, j) == 0)
+				break;
+			T->slots[i] = T->slots[j];
+			i = j;
+		}
+		T->slots[i].cell = NULL;
+	}
+
+	if (T->dataDeleter != NULL)
+		T->dataDeleter(table_getDatum(cell));
+
+	releaseCell(T, cell);
+
+	T->count_elems = T->count_elems - 1;
+
+	// shrink the table if it has drained
+	table_checkLoad(T);
+}
+
+void table_iterate(table* T, tableIterator* it) {
+	it->T = T;
+	it->slot = 0;
+}
+
+void* table_nextCell(tableIterator* it) {
+
+	// the iterator stands at the slot after the last cell it returned
+	// the slots of the old array, if any, are counted after the current ones
+	table* T = it->T;
+	void* cell;
+
+	while (it->slot < T->count_slots + T->count_old) {
+		if (it->slot < T->count_slots)
+			cell = T->slots[it->slot].cell;
+		else
+			cell = T->old[it->slot - T->count_slots].cell;
+		it->slot = it->slot + 1;
+		if (cell != NULL && cell != MOVED)
+			return cell;
+	}
+	return NULL;
+}
@@ -1,43 +1,71 @@
 #ifndef _table_h
 #define _table_h
 
+#include <stdint.h>
+#include <stddef.h>
+
 typedef void (*dataCleanFn)(void* addr);
 
 typedef struct tablePrototype table;
 
-// create the table by specifying the size of the data (List*), 
-// the initial capacity (set in venmoGraphParams), and the cleaner function (our list remover)
+// The table is a flat array of slots with open addressing. A slot holds the
+// hash of a key and the address of its cell, and the cell holds the datum
+// and the key. Slots move around as entries come and go, but cells never
+// do, so the address of a cell is a stable handle to its entry.
+
+// create the table by specifying the size of the data, 
+// the initial capacity (set in venmoGraphParams), and the cleaner function
 table* table_create(int dataSize, int initCapacity, dataCleanFn fn);
 
 // destroy the table
 void table_destroy(table* T);
 
-// recover the number of cells (nodes), i.e. the number of unique entries in the table (not hash cells)
+// the hash the tables use for a key
+// the slot of a key is taken from the low bits of its hash, so other uses
+// of the hash (such as picking the shard of a node) should take the high bits
+uint64_t table_hash(char* key, int len);
+
+// recover the number of entries in the table (not slots)
 int table_count(table* T);
 
-// check the load of the table and rehash if necessary
+// the bytes the table holds: its slots (both arrays during a resize) and
+// the cells of its entries
+size_t table_bytes(table* T);
+
+// check the load of the table, and rehash to more slots if it is too full,
+// or to fewer slots if it has drained. 1 is returned if it was rehashed
 int table_checkLoad(table* T);
 
 // add an entry to the table
-// the key must be a string
-// as a void*, the addr can be the address of any data type, but in our project, we use List**
-void* table_put(table* T, char* key, void* addr);
-
-// get the address of a cell of memory from the table
-// then use that address to get the key
-// since the key is a string whose length varies, we need 
-// it and the original address to get the actual datum 
-void* table_getCell(table* T, char* key);
-void* table_getKey(void* cell);
-void* table_getDatum(table* T, void* cell, char* key);
-
-// remove an entry from the table by specifying the key
-void table_remove(table* T, char* key);
-
-// iterate through the entries in the table
-// begin by setting cell = firstCell and key = getKey(cell)
-// then in a loop update cell = nextCell(T,cell,key) and key = getKey(cell).
-void* table_firstCell(table* T);
-void* table_nextCell(table* T, void* prevCell, char* key);
+// the key is given by its first character and its length, so it need not be
+// terminated; the table stores a terminated copy in the cell
+// the datum is copied from addr. the cell of the entry is returned
+void* table_put(table* T, char* key, int keyLen, void* addr);
+
+// get the cell of a key, or NULL if the key is not in the table
+void* table_getCell(table* T, char* key, int keyLen);
+
+// use the cell to get the (terminated) key, its length, and the datum
+// the cell keeps the length, so it is not measured again
+char* table_getKey(table* T, void* cell);
+int table_getKeyLen(void* cell);
+void* table_getDatum(void* cell);
+
+// remove the entry of a cell from the table
+void table_remove(table* T, void* cell);
+
+// An iterator through the cells of the table. It remembers the slot it
+// stands at, so every step just walks to the next full slot.
+// The table must not change while it is iterated.
+typedef struct {
+	table* T;
+	int slot;
+} tableIterator;
+
+// iterate through the cells in the table
+// begin with iterate(T, &it)
+// then in a loop update cell = nextCell(&it) until it is NULL.
+void table_iterate(table* T, tableIterator* it);
+void* table_nextCell(tableIterator* it);
 
 #endif
@@ -0,0 +1,63 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "parser.h"
+#include "reader.h"
+#include "eventlog.h"
+
+// venConvert parses an input file of the challenge once, and writes it as an
+// event log (see eventlog.h), which venGraph replays without parsing, e.g.
+//   ./venConvert venmo_input/venmo-trans.txt venmo-trans.vlog
+//   ./venGraph venmo-trans.vlog venmo_output/output.txt
+// "-" reads the standard input.
+
+int main(int argc, char* argv[]) {
+
+	reader* fp_in;
+	eventlogWriter* fp_out;
+	parser* PRS;
+	venmoEvent ev;
+	char* line;
+	int lineLen;
+	unsigned long int lines = 0, faulty = 0;
+
+	if (argc != 3) {
+		printf("\nERROR: give the input file and the event log to write\n\n");
+		exit(0);
+	}
+
+	fp_in = reader_open(argv[1]);
+	if (fp_in == NULL) {
+		printf("\n\nERROR: input file could not be opened\n\n");
+		exit(0);
+	}
+	fp_out = eventlog_create(argv[2]);
+	if (fp_out == NULL) {
+		printf("\n\nERROR: event log could not be created\n\n");
+		reader_close(fp_in);
+		exit(0);
+	}
+
+	// A faulty line gets a record too, so the log holds every line of the
+	// input, and the lines of the output still match the valid ones.
+	PRS = parser_create();
+	while (reader_next(fp_in, &line, &lineLen)) {
+		if (parser_parse(PRS, line, lineLen, &ev)) {
+			eventlog_append(fp_out, &ev);
+		}
+		else {
+			eventlog_append(fp_out, NULL);
+			faulty++;
+		}
+		lines++;
+	}
+	parser_destroy(PRS);
+	reader_close(fp_in);
+
+	if (!eventlog_finish(fp_out)) {
+		printf("\n\nERROR: event log could not be written\n\n");
+		exit(1);
+	}
+
+	printf("\nConverted %lu lines, %lu of them faulty\n\n", lines, faulty);
+	return 0;
+}
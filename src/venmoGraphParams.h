@@ -1,28 +1,169 @@
-#ifndef _venmoGraphParams_h
-#define _venmoGraphParams_h
-
-// Parameters of the project
-
-// MAX_AGE is the maximum window in seconds.
-// It is currently set to the 60 specified in the challenge.
-#define MAX_AGE 60
-
-// MAX_STR_LEN is the maximum length of an actor's or target's name.
-#define MAX_STR_LEN 200
-
-// The graph is stored in a table.
-// The cells of the table contain the nodes of the graph.
-// Multiple nodes can be stored in each cell.
-// The table is expanded when the probability increases of a cell
-// containing too many nodes.
-// The initial number of cells in the table is given in INITIAL_TABLE_SIZE
-#define INITIAL_TABLE_SIZE 4
-
-// For the fastMedian algorithm, an array is created to store the frequency
-// of each degree (called length in the code). 
-// INIT_MAX_LEN is the initial guess of the maximum degree.
-// Don't worry about setting it too low; like the above table, this array
-// will grow dynamically and very quickly (every expansion is a doubling).
-#define INIT_MAX_LEN 10
-
-#endif
+#ifndef _venmoGraphParams_h
+#define _venmoGraphParams_h
+
+// Parameters of the project
+
+// MAX_AGE is the maximum window in seconds.
+// It is currently set to the 60 specified in the challenge.
+#define MAX_AGE 60
+
+// MAX_AGE is only the default. The fifth input to the executable can give
+// several windows instead, e.g. "60,300,3600", and then every line of the
+// output has one median per window. MAX_WINDOWS is the most it accepts.
+#define MAX_WINDOWS 8
+
+// MAX_STR_LEN is the maximum length of an actor's or target's name.
+#define MAX_STR_LEN 200
+
+// The graph is stored in a table.
+// The cells of the table contain the nodes of the graph.
+// Multiple nodes can be stored in each cell.
+// The table is expanded when the probability increases of a cell
+// containing too many nodes.
+// The initial number of cells in the table is given in INITIAL_TABLE_SIZE
+#define INITIAL_TABLE_SIZE 4
+
+// When the table is resized, its entries are moved to the new array a few
+// at a time, with every later insertion and removal, so that no single line
+// of the input waits for the whole table to be moved. Set INCREMENTAL_REHASH
+// to 0 to move them all at once instead.
+#define INCREMENTAL_REHASH 1
+
+// For the fastMedian algorithm, a histogram is created to store the frequency
+// of each degree (called length in the code). 
+// INIT_MAX_LEN is the initial guess of the maximum degree.
+// Don't worry about setting it too low; like the above table, this histogram
+// will grow dynamically and very quickly (every expansion is a doubling,
+// and nothing is copied).
+#define INIT_MAX_LEN 10
+
+// The list blocks, the table cells, and the entries of the expiry and edge
+// indices all have fixed layouts, so they are cut out of large slabs of
+// memory rather than malloc'd one by one. Freed records are reused, and all
+// the slabs are released at once when the structure is destroyed.
+// POOL_SLAB_SIZE is the size of a slab in bytes.
+#define POOL_SLAB_SIZE 65536
+
+// Besides the median, every line of the output can report more statistics
+// of the degrees, as extra columns separated by spaces:
+// first NUM_QUANTILES quantiles of the degrees, taken from the list QUANTILES
+// (0.90 is the degree that 90% of the nodes do not exceed),
+// then the TOP_K nodes of the highest degrees, as name:degree.
+// Both are 0 by default, so the output holds just the median.
+#define NUM_QUANTILES 0
+#define QUANTILES {0.90, 0.99}
+#define TOP_K 0
+
+// The input file is memory-mapped and split into lines in place, which is
+// much faster for large files than reading it through stdio. Lines of any
+// length are accepted. Set INPUT_MMAP to 0 to read the file in blocks
+// instead; input that is not a regular file is always read in blocks.
+#define INPUT_MMAP 1
+
+// When the input is a stream (stdin, a pipe or a FIFO), every median is
+// handed to the output as soon as possible. Flushing after every single
+// event would cost a system call per event, so the medians are flushed in
+// batches: after STREAM_FLUSH_EVENTS medians, or once the oldest unflushed
+// median has waited STREAM_FLUSH_USEC microseconds, whichever comes first.
+// The output is always flushed before the program waits for more input,
+// so a quiet stream never holds medians back.
+#define STREAM_FLUSH_EVENTS 32
+#define STREAM_FLUSH_USEC 50
+
+// The medians are formatted into a large buffer, which is written to the
+// output file in big pieces. For replays of large files, set OUTPUT_MMAP to
+// 1 to write the medians straight into the memory-mapped output file
+// instead. The file is then extended a window at a time and cut to its
+// real size when it is closed, so do not follow it while it is written.
+// Output that is not a regular file is always written from the buffer.
+#define OUTPUT_MMAP 0
+
+// When the input is a regular file, it is replayed by a pipeline of threads:
+// PIPELINE_PARSERS threads split the lines and parse them (with more than one,
+// each parses every PIPELINE_PARSERS-th line), one thread applies the events
+// to the graph in the order of the input, and one thread formats and writes
+// the output. They hand the events and the medians over in rings of
+// PIPELINE_RING_SIZE records, a power of two. The output is exactly the same
+// as with a single thread. Set PIPELINE_PARSERS to 0 to do everything in one
+// thread. A stream is always processed in one thread, as its lines come in,
+// since every hand-over between threads would make its medians later.
+#define PIPELINE_PARSERS 1
+#define PIPELINE_RING_SIZE 4096
+
+// The graph thread of the pipeline takes the lines that are already in the
+// rings, up to INGEST_BATCH of them, and ingests them as one batch, which
+// advances the max time and takes the medians less often (see engine.h).
+// It never waits for more lines to fill a batch. 1 ingests event by event.
+#define INGEST_BATCH 64
+
+// The graph itself can be split among GRAPH_SHARDS threads as well, every
+// node going to a shard by the hash of its name. Each shard keeps the degrees
+// of its own nodes, and the histograms of the shards are merged event by
+// event, so the output is still exactly the same. A branch between the nodes
+// of two shards is kept by both, so sharding only pays off with enough cores
+// for all the threads (the parsers, the shards, a merger and a writer).
+// Sharding needs the pipeline, and it is not used when TOP_K > 0, with the
+// naive median, or when the graph is printed. 0 or 1 keeps the graph whole.
+#define GRAPH_SHARDS 0
+
+// For recomputing the medians of a large archived file, set BACKFILL_WORKERS
+// to the number of cores. The file is then cut into that many chunks, which
+// are processed at the same time, each by a thread with its own graph. A
+// thread first rebuilds the graph at the start of its chunk from the lines
+// just before it (the window is only MAX_AGE seconds wide), and the outputs
+// of the chunks are joined in order, so the output is exactly the same.
+// The outputs of the chunks are kept in temporary files in TMPDIR (or /tmp)
+// until then.
+// The backfill is not used for streams, when TOP_K > 0, or when the graph is
+// printed. 0 or 1 turns it off.
+#define BACKFILL_WORKERS 0
+
+// Events that arrive out of order can be sorted before they reach the graph.
+// With REORDER_LATENESS > 0, an event waits in a reorder buffer until the
+// largest time stamp seen so far is REORDER_LATENESS seconds past its own,
+// and the events are applied in the order of their time stamps. An event
+// that arrives even later than that is applied at once, and counted as late
+// in the timing report. Every event still gets its line of the output, in
+// the order of the input, but the line only goes out once the event has been
+// applied. 0 turns the buffer off, and the events are applied as they come.
+// The backfill and the shards are not used with the buffer.
+#define REORDER_LATENESS 0
+
+// To see where the time of an event goes, set INSTRUMENT to 1. Every stage
+// of an event (parsing, looking up the names, putting in the branch, pruning,
+// resizing a table, the median and the output) is then timed with the
+// monotonic clock into a histogram, and the events are counted as they go.
+// A snapshot of all of it is appended to the file STATS_PATH every
+// STATS_INTERVAL lines of the output (0 for none), and once more at the end,
+// as one JSON object per line. With INSTRUMENT 0 none of it is compiled.
+#define INSTRUMENT 0
+#define STATS_PATH "venGraph.stats"
+#define STATS_INTERVAL 100000
+
+// A process that restarts would begin with an empty graph, and its medians
+// would be wrong until a whole window of events had come in again. With
+// SNAPSHOT_INTERVAL > 0, a snapshot of the graph is written to the file
+// SNAPSHOT_PATH every SNAPSHOT_INTERVAL lines of the output, and at the end,
+// by a child process, so the events keep coming in meanwhile. If the file is
+// there when the program starts, the graph is loaded from it, and the input
+// is taken up where the snapshot left off (see "Snapshots" in the readme).
+// Delete the file to start afresh. 0 turns the snapshots off.
+// SNAPSHOT_INTERVAL is only the default: the environment variable
+// VENGRAPH_SNAPSHOT_INTERVAL sets the interval of a run without a rebuild.
+// The snapshots are not taken with the reorder buffer, the shards or the
+// backfill, which do not hold the graph of a part of the input in one place.
+#define SNAPSHOT_INTERVAL 0
+#define SNAPSHOT_PATH "venGraph.snap"
+
+// To run many processes side by side, the memory of the graph can be held to
+// a budget. With MEMORY_BUDGET > 0, the structures of the graph (the names,
+// the lists and their blocks, the expiry and edge indices and the histograms)
+// are kept below MEMORY_BUDGET bytes by evicting the oldest branches ahead of
+// their time, and an event older than the evicted branches is kept out of
+// the graph (see "Memory" in the readme). Set REPORT_MEMORY to 1 to add the
+// bytes of the graph after every event as the last column of the output.
+// The backfill and the shards are not used with either of them.
+#define MEMORY_BUDGET 0
+#define REPORT_MEMORY 0
+
+#endif
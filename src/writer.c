@@ -0,0 +1,238 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include "writer.h"
+#include "venmoGraphParams.h"
+
+// size of the output buffer, and of the window of a memory-mapped output
+// file. the window must be a multiple of the page size, and at least two
+// pages, since the page filled last is mapped again at its start.
+#define WRITE_BUFFER_SIZE (1 << 20)
+#define MAP_WINDOW_SIZE (16 << 20)
+
+// the longest number we ever format: 20 digits, ".50" and the newline
+#define MAX_MEDIAN_LEN 24
+
+struct writerPrototype {
+
+	int fd;
+
+	// the buffer, or the mapped window of the output file
+	char* data;
+	size_t size;
+	int mapped;
+
+	// the part of the data filled so far
+	size_t pos;
+
+	// where the window starts in a mapped output file
+	off_t offset;
+};
+
+writer* writer_open(char* path) {
+
+	struct stat st;
+
+	int fd;
+	if (strcmp(path, "-") == 0)
+		fd = STDOUT_FILENO;
+	else
+		fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0666);
+	if (fd < 0)
+		return NULL;
+
+	writer* W = malloc(sizeof(writer));
+	assert(W != NULL);
+
+	W->fd = fd;
+	W->pos = 0;
+	W->offset = 0;
+	W->mapped = 0;
+	W->size = WRITE_BUFFER_SIZE;
+
+	// A regular output file can be mapped. The window is mapped lazily, 
+	// the first time a median is added.
+	if (OUTPUT_MMAP && fd != STDOUT_FILENO && fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+		W->mapped = 1;
+		W->size = 0;
+		W->data = NULL;
+		return W;
+	}
+
+	W->data = malloc(W->size);
+	assert(W->data != NULL);
+
+	return W;
+}
+
+// write the whole buffer to the output file
+static void drain(writer* W) {
+
+	ssize_t n;
+	size_t done = 0;
+
+	while (done < W->pos) {
+		n = write(W->fd, W->data + done, W->pos - done);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0) {
+			printf("\n\nFATAL ERROR: cannot write the output\n\n");
+			abort();
+		}
+		done = done + n;
+	}
+	W->pos = 0;
+}
+
+// move the window of a mapped output file past the part filled so far
+static void slide(writer* W) {
+
+	// The file is extended by a whole window at a time, and the unused
+	// end is cut off again when the file is closed.
+
+	if (W->data != NULL) {
+		munmap(W->data, W->size);
+		W->offset = W->offset + W->pos;
+	}
+
+	// the window starts on a page boundary, so the part of the current
+	// page that is already filled is mapped again
+	long page = sysconf(_SC_PAGESIZE);
+	off_t start = W->offset - W->offset % page;
+
+	W->pos = W->offset - start;
+	W->offset = start;
+	W->size = MAP_WINDOW_SIZE;
+
+	if (ftruncate(W->fd, W->offset + W->size) != 0) {
+		printf("\n\nFATAL ERROR: cannot extend the output file\n\n");
+		abort();
+	}
+	W->data = mmap(NULL, W->size, PROT_READ | PROT_WRITE, MAP_SHARED, W->fd, W->offset);
+	if (W->data == MAP_FAILED) {
+		printf("\n\nFATAL ERROR: cannot map the output file\n\n");
+		abort();
+	}
+}
+
+void writer_close(writer* W) {
+
+	if (W->mapped) {
+		if (W->data != NULL) {
+			munmap(W->data, W->size);
+			if (ftruncate(W->fd, W->offset + W->pos) != 0) {
+				printf("\n\nFATAL ERROR: cannot truncate the output file\n\n");
+				abort();
+			}
+		}
+	}
+	else {
+		drain(W);
+		free(W->data);
+	}
+
+	if (W->fd != STDOUT_FILENO)
+		close(W->fd);
+	free(W);
+}
+
+void writer_flush(writer* W) {
+	
+	// the pages of a mapped file are already shared with its readers
+	if (!W->mapped)
+		drain(W);
+}
+
+// make room for len more characters
+static void reserve(writer* W, int len) {
+	if (W->size - W->pos < (size_t)len) {
+		if (W->mapped)
+			slide(W);
+		else
+			drain(W);
+	}
+}
+
+// write the digits of a whole number at p and return the end
+static char* putDigits(char* p, unsigned long int whole) {
+
+	char digits[20];
+	int n = 0;
+
+	// the digits come out backwards
+	do {
+		digits[n] = '0' + whole % 10;
+		whole = whole / 10;
+		n++;
+	} while (whole > 0);
+
+	while (n > 0) {
+		n--;
+		*p = digits[n];
+		p++;
+	}
+	return p;
+}
+
+void writer_putNumber(writer* W, float value) {
+
+	// A median is a degree or the mean of two degrees, so twice the median
+	// is a whole number. Its last bit decides between ".00" and ".50", and
+	// the rest is the whole part, so no floating point formatting is needed.
+
+	unsigned long int halves = (unsigned long int)(value*2 + 0.5f);
+
+	reserve(W, MAX_MEDIAN_LEN);
+
+	char* p = putDigits(W->data + W->pos, halves >> 1);
+
+	p[0] = '.';
+	p[1] = (halves & 1) ? '5' : '0';
+	p[2] = '0';
+
+	W->pos = p + 3 - W->data;
+}
+
+void writer_putInt(writer* W, unsigned long int value) {
+	reserve(W, MAX_MEDIAN_LEN);
+	W->pos = putDigits(W->data + W->pos, value) - W->data;
+}
+
+void writer_putText(writer* W, char* str, int len) {
+
+	// a piece of text longer than the buffer goes in several parts
+	int part;
+	while (len > 0) {
+		reserve(W, len < MAX_MEDIAN_LEN ? len : MAX_MEDIAN_LEN);
+		part = W->size - W->pos;
+		if (part > len)
+			part = len;
+		memcpy(W->data + W->pos, str, part);
+		W->pos = W->pos + part;
+		str = str + part;
+		len = len - part;
+	}
+}
+
+void writer_putChar(writer* W, char c) {
+	reserve(W, 1);
+	W->data[W->pos] = c;
+	W->pos++;
+}
+
+void writer_putMedian(writer* W, float median) {
+	
+	// putNumber left room for the newline
+	writer_putNumber(W, median);
+	W->data[W->pos] = '\n';
+	W->pos++;
+}
@@ -0,0 +1,30 @@
+#ifndef _writer_h
+#define _writer_h
+
+typedef struct writerPrototype writer;
+
+// open the output file at path, or the standard output if the path is "-"
+// the medians are collected in a large buffer and written out in big pieces,
+// or, if OUTPUT_MMAP is set in venmoGraphParams, written straight into the
+// memory-mapped file
+// NULL is returned if the file cannot be opened
+writer* writer_open(char* path);
+
+// flush and close the output file
+void writer_close(writer* W);
+
+// add a median to the output, formatted like "%.2f\n"
+// the median must be a whole number or a half (a degree, or the mean of two)
+void writer_putMedian(writer* W, float median);
+
+// the pieces of a line with more columns than the median
+// a number is formatted like a median, without the newline
+void writer_putNumber(writer* W, float value);
+void writer_putInt(writer* W, unsigned long int value);
+void writer_putText(writer* W, char* str, int len);
+void writer_putChar(writer* W, char c);
+
+// hand everything added so far over to the reader of the output
+void writer_flush(writer* W);
+
+#endif
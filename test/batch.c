@@ -0,0 +1,147 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "../bench/workload.h"
+#include "../src/parser.h"
+#include "../src/engine.h"
+
+// batch checks that engine_ingestBatch gives exactly the statistics of
+// engine_ingest. It feeds a synthetic workload (see "workload.h") to two
+// engines, one event at a time to the first and in batches of random sizes
+// to the second, and compares every line of statistics. Usage:
+//   ./batch [workload options] [-w windows] [-m 1|2] [-b largest batch]
+// The windows are lengths in seconds separated by commas, as in the fifth
+// input of venGraph. The exit status is 1 at the first line that differs.
+
+#define MAX_BATCH 1024
+
+// the windows of the medians, as in parseWindows of main.c
+static int parseWindows(char* list, windowSet* W) {
+
+	char* end;
+	long int age;
+
+	W->count = 0;
+	for (;;) {
+		age = strtol(list, &end, 10);
+		if (end == list || age <= 0 || W->count == MAX_WINDOWS)
+			return 0;
+		W->ages[W->count] = age;
+		W->count++;
+
+		if (*end == '\0')
+			return 1;
+		if (*end != ',')
+			return 0;
+		list = end + 1;
+	}
+}
+
+static int sameStats(statsLine* A, statsLine* B) {
+
+	int i;
+
+	if (A->numMedians != B->numMedians || A->numTop != B->numTop || A->memory != B->memory)
+		return 0;
+	if (memcmp(A->medians, B->medians, A->numMedians*sizeof(float)) != 0)
+		return 0;
+	if (memcmp(A->quantiles, B->quantiles, sizeof(A->quantiles)) != 0)
+		return 0;
+	for (i=0; i<A->numTop; i++) {
+		if (A->topDegs[i] != B->topDegs[i] || A->topLens[i] != B->topLens[i])
+			return 0;
+		if (memcmp(A->topNames[i], B->topNames[i], A->topLens[i]) != 0)
+			return 0;
+	}
+	return 1;
+}
+
+int main(int argc, char* argv[]) {
+
+	workloadParams P;
+	workload* W;
+	windowSet windows;
+	engine* single;
+	engine* batched;
+	parser* PRS = parser_create();
+
+	static char lines[MAX_BATCH][WORKLOAD_MAX_LINE];
+	static venmoEvent evs[MAX_BATCH];
+	static statsLine one[MAX_BATCH];
+	static statsLine many[MAX_BATCH];
+
+	int medianAlg = 2;
+	int largest = 64;
+	unsigned long int checked = 0;
+	int len, valid, opt, n, size, i;
+
+	windows.count = 1;
+	windows.ages[0] = MAX_AGE;
+	workload_defaults(&P);
+	P.events = 100000;
+	P.users = 2000;
+
+	while ((opt = getopt(argc, argv, WORKLOAD_OPTIONS "w:m:b:")) != -1) {
+		if (opt == 'w') {
+			if (!parseWindows(optarg, &windows)) {
+				printf("\n\nERROR: invalid windows\n\n");
+				exit(0);
+			}
+		}
+		else if (opt == 'm') {
+			medianAlg = atoi(optarg);
+		}
+		else if (opt == 'b') {
+			largest = atoi(optarg);
+			if (largest < 1 || largest > MAX_BATCH) {
+				printf("\n\nERROR: the largest batch must be within 1 and %d\n\n", MAX_BATCH);
+				exit(0);
+			}
+		}
+		else if (!workload_option(&P, opt, optarg)) {
+			printf("\n\nERROR: invalid option; the options are %s-w-m-b\n\n", WORKLOAD_OPTIONS);
+			exit(0);
+		}
+	}
+
+	single = engine_create(&windows, medianAlg, 0);
+	batched = engine_create(&windows, medianAlg, 0);
+	srand(P.seed);
+
+	// The names of an event point into its line, so the lines of a batch
+	// stay put until both engines have taken it.
+	W = workload_create(&P);
+	len = 1;
+	while (len > 0) {
+		size = 1 + rand() % largest;
+		n = 0;
+		while (n < size && (len = workload_next(W, lines[n], &valid)) > 0) {
+			if (parser_parse(PRS, lines[n], len, &evs[n]))
+				n++;
+		}
+
+		for (i=0; i<n; i++)
+			engine_ingest(single, &evs[i], &one[i]);
+		engine_ingestBatch(batched, evs, n, many);
+
+		for (i=0; i<n; i++) {
+			if (!sameStats(&one[i], &many[i])) {
+				printf("FAIL: event %lu (time %lu) differs, first median %.1f alone and %.1f in a batch\n",
+					checked + i + 1, evs[i].time, one[i].medians[0], many[i].medians[0]);
+				return 1;
+			}
+		}
+		checked = checked + n;
+	}
+	workload_destroy(W);
+
+	printf("PASS: %lu events\n", checked);
+
+	engine_destroy(single);
+	engine_destroy(batched);
+	parser_destroy(PRS);
+	return 0;
+}
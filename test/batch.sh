@@ -0,0 +1,26 @@
+#!/usr/bin/env bash
+
+# Check that a batch of events gives the same statistics as the events one
+# at a time (see "Engine" in the readme), on workloads in and out of order,
+# with one window and with several, and with both median algorithms.
+
+cd "$(dirname "$0")/.."
+
+# the engine is compiled just as in run.sh, without the driver of venGraph
+eval "$(grep '^gcc.*-o venGraph' run.sh | sed 's# src/main.c -o venGraph# bench/workload.h bench/workload.c test/batch.c -lm -o test/batch#')" || exit 1
+
+status=0
+run() {
+	echo "batch $*"
+	test/batch "$@" || status=1
+}
+
+run
+run -w 60,10,30
+run -j 0.3 -J 90 -w 60,10,30
+run -j 0.05 -J 120 -r 1000 -u 50000 -w 5,60
+run -r 0.05 -j 0.2 -J 40 -w 60,20 -b 256
+run -r 20 -j 0.5 -J 10 -w 3 -f 0.1 -S 7
+run -m 1 -n 20000 -j 0.2 -J 30 -w 60,10
+
+exit $status